@@ -0,0 +1,93 @@
+/*
+ * Arena Allocator
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <data/arena.h>
+
+struct arena_block {
+	struct arena_block *next;
+};
+
+#define ALIGN(x)  (((x) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1))
+#define HEAD      ALIGN (sizeof (struct arena_block))
+
+void arena_init (struct arena *o)
+{
+	o->block = NULL;
+	o->next  = NULL;
+	o->end   = NULL;
+	o->size  = ARENA_MIN;
+	o->count = 0;
+}
+
+void arena_fini (struct arena *o)
+{
+	struct arena_block *b;
+
+	while ((b = o->block) != NULL) {
+		o->block = b->next;
+		free (b);
+	}
+}
+
+static int arena_grow (struct arena *o, size_t size)
+{
+	const size_t total = HEAD + size > o->size ? HEAD + size : o->size;
+	struct arena_block *b;
+
+	if ((b = malloc (total)) == NULL)
+		return 0;
+
+	b->next  = o->block;
+	o->block = b;
+	o->next  = (char *) b + HEAD;
+	o->end   = (char *) b + total;
+
+	if (o->size < ARENA_MAX)
+		o->size *= 2;
+
+	return 1;
+}
+
+/* takes size bytes at the alignment (power of two) */
+static void *arena_take (struct arena *o, size_t size, size_t align)
+{
+	size_t pad = -(uintptr_t) o->next & (align - 1);
+	void *p;
+
+	if (pad + size > (size_t) (o->end - o->next)) {
+		if (!arena_grow (o, size))
+			return NULL;
+
+		pad = 0;
+	}
+
+	p = o->next + pad;
+	o->next += pad + size;
+	++o->count;
+	return p;
+}
+
+void *arena_alloc (struct arena *o, size_t size)
+{
+	return arena_take (o, size, ARENA_ALIGN);
+}
+
+char *arena_strdup (struct arena *o, const char *s)
+{
+	const size_t len = strlen (s) + 1;
+	char *p;
+
+	if ((p = arena_take (o, len, 1)) != NULL)
+		memcpy (p, s, len);
+
+	return p;
+}
@@ -27,8 +27,8 @@ size_t atom_seq_hash (const void *o)
 	const void **p = (void *) o;
 	size_t state, i;
 
-	for (state = 0, i = 0; p[i] != NULL; ++i)
-		state = hash (state, p[i], sizeof (p[0]));
+	for (state = hash_seed, i = 0; p[i] != NULL; ++i)
+		state = hash_step (state, (uintptr_t) p[i]);
 
-	return state;
+	return hash_mix (state ^ i);
 }
@@ -16,7 +16,7 @@ int atom_eq (const void *a, const void *b)
 
 size_t atom_hash (const void *o)
 {
-	return hash (0, &o, sizeof (o));
+	return hash_mix ((uintptr_t) o ^ hash_seed);
 }
 
 const struct data_type atom_type = {
@@ -6,12 +6,49 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <errno.h>
+#include <stdlib.h>
+
 #include <parser/automata.h>
 #include <parser/grammar.h>
 
-static
-int state_push_item (struct state *o, const struct rule *rule, size_t pos);
+struct build {
+	struct state_seq queue;
+	struct bitset closure;
+	size_t *count;                /* kernel size by symbol id  */
+	const struct symbol **order;  /* symbols in order of arrows */
+	const struct item **shift;    /* closure items to shift     */
+	const struct item **kernel;   /* kernels grouped by symbol  */
+};
+
+static int build_init (struct build *o, const struct grammar *g)
+{
+	state_seq_init (&o->queue);
+	bitset_init (&o->closure);
+
+	o->count  = calloc (g->nsymbols + 1, sizeof (o->count[0]));
+	o->order  = malloc (sizeof (o->order[0])  * (g->nsymbols + 1));
+	o->shift  = malloc (sizeof (o->shift[0])  * (g->nitems + 1));
+	o->kernel = malloc (sizeof (o->kernel[0]) * (g->nitems + 1));
+
+	if (o->count != NULL && o->order != NULL && o->shift != NULL &&
+	    o->kernel != NULL)
+		return 1;
+
+	free (o->count);
+	free (o->order);
+	free (o->shift);
+	free (o->kernel);
+	return 0;
+}
+
+static void build_fini (struct build *o)
+{
+	bitset_fini (&o->closure);
+	free (o->count);
+	free (o->order);
+	free (o->shift);
+	free (o->kernel);
+}
 
 static int state_push_symbol (struct state *o, const struct symbol *nt)
 {
@@ -21,39 +58,69 @@ static int state_push_symbol (struct state *o, const struct symbol *nt)
 	if (nt == NULL || nt->rules == NULL)
 		return 1;
 
+	if (!ht_reserve (&o->items, o->items.count + nt->rules->count))
+		return 0;
+
 	ht_foreach (i, r, nt->rules)
-		if (!state_push_item (o, r, 0) && errno != EEXIST)
+		if (!state_add_item (o, r, 0))
 			return 0;
 
 	return 1;
 }
 
-static
-int state_push_item (struct state *o, const struct rule *rule, size_t pos)
-{
-	return state_add_item (o, rule, pos) &&
-	       state_push_symbol (o, rule->prod[pos]);
-}
-
-static int state_build (struct state *o)
+/*
+ * Calculates arrows of the state and places newly discovered target
+ * states at the tail of the build queue. Known targets are replaced
+ * with existing states.
+ *
+ * Kernel items of targets are counted and grouped by symbol first, thus
+ * arrow set and item set of every target are allocated once.
+ */
+static int state_build (struct state *o, struct build *b)
 {
-	size_t i;
-	const struct item *it;
+	const struct item *items = o->automata->items;
+	size_t i, m, n, total, start, end;
 	const struct symbol *s;
 	struct arrow *a;
 	const struct state *next;
 
-	ht_foreach (i, it, &o->items)
-		if ((s = it->rule->prod[it->pos]) != NULL) {
-			if ((a = state_add_arrow (o, s)) == NULL &&
-			    errno != EEXIST)
-				return 0;
+	if (!state_closure (o, &b->closure))
+		return 0;
 
-			if (!state_push_item (a->to, it->rule, it->pos + 1) &&
-			    errno != EEXIST)
-				return 0;
+	m = 0, n = 0;
+
+	bitset_foreach (i, &b->closure)
+		if ((s = items[i].rule->prod[items[i].pos]) != NULL) {
+			b->shift[m++] = items + i;
+
+			if (b->count[s->id]++ == 0)
+				b->order[n++] = s;
 		}
 
+	for (i = 0, total = 0; i < n; ++i) {
+		s = b->order[i];
+		total += b->count[s->id];
+		b->count[s->id] = total - b->count[s->id];
+	}
+
+	for (i = 0; i < m; ++i) {
+		s = b->shift[i]->rule->prod[b->shift[i]->pos];
+		b->kernel[b->count[s->id]++] = b->shift[i] + 1;
+	}
+
+	if (!ht_reserve (&o->arrows, n))
+		return 0;
+
+	for (i = 0, start = 0; i < n; ++i, start = end) {
+		s   = b->order[i];
+		end = b->count[s->id];
+		b->count[s->id] = 0;
+
+		if ((a = state_add_arrow (o, s)) == NULL ||
+		    !state_add_items (a->to, b->kernel + start, end - start))
+			return 0;
+	}
+
 	ht_foreach (i, a, &o->arrows) {
 		next = automata_add_state (o->automata, a->to);
 		if (next != a->to) {
@@ -64,27 +131,43 @@ static int state_build (struct state *o)
 				return 0;
 		}
 		else
-			if (!state_build (a->to))
-				return 0;
+			state_seq_enqueue (&b->queue, a->to);
 	}
 
 	return 1;
 }
 
+/*
+ * States are built in breadth-first order: the queue holds states
+ * discovered but not yet expanded, thus stack usage does not depend on
+ * the automata size.
+ */
 int automata_build (struct automata *a, const struct grammar *g)
 {
+	struct build b;
 	struct state *s;
 
-	if ((s = state_alloc (a)) == NULL)
+	if (!automata_prepare (a, g) || !build_init (&b, g))
 		return 0;
 
+	if ((s = state_alloc (a)) == NULL)
+		goto no_state;
+
 	if (!state_push_symbol (s, g->start) ||
-	    automata_add_state (a, s) != s   ||
-	    !state_build (s))
-		goto error;
+	    automata_add_state (a, s) != s)
+		goto no_start;
+
+	state_seq_enqueue (&b.queue, s);
+
+	while ((s = state_seq_dequeue (&b.queue)) != NULL)
+		if (!state_build (s, &b))
+			goto no_state;
 
+	build_fini (&b);
 	return 1;
-error:
+no_start:
 	state_free (s);
+no_state:
+	build_fini (&b);
 	return 0;
 }
@@ -6,130 +6,396 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <data/emit.h>
 #include <parser/automata-code.h>
 #include <parser/automata-show.h>
 
-static size_t state_index (const struct state *s)
+struct frag {
+	const char *s;
+	size_t len;
+};
+
+/*
+ * Code generator state: names of symbols are formatted once, reductions
+ * are decided once per state, token sets are marked by stamps thus
+ * emission does not allocate memory.
+ */
+struct code {
+	struct emit out;
+	const struct grammar *g;
+
+	char *text;             /* storage of fragments                 */
+	struct frag *label;     /* "\tcase TOKEN_x:" by terminal id, and
+				   "\tcase 0:" for the end of input      */
+	struct frag *nt;        /* "NT_x" by non-terminal index          */
+
+	const struct rule **reduce;  /* reduction by state index, if any */
+
+	int empty;                   /* grammar has empty rules          */
+	struct bitset closure, shifts, reduces;
+	size_t *shifted;             /* stamps by terminal id            */
+	size_t stamp;
+};
+
+static char *frag_make (struct frag *o, char *p, const char *prefix,
+			const char *name, const char *suffix)
+{
+	const size_t a = strlen (prefix), b = strlen (name);
+	const size_t c = strlen (suffix);
+
+	memcpy (p, prefix, a);
+	memcpy (p + a, name, b);
+	memcpy (p + a + b, suffix, c);
+
+	o->s   = p;
+	o->len = a + b + c;
+	return p + o->len;
+}
+
+static int code_names (struct code *o)
 {
-	return ht_index (&s->automata->states, s);
+	const struct grammar *g = o->g;
+	const size_t nterms = g->nterms, nnt = g->nsymbols - nterms;
+	size_t size = sizeof ("\tcase 0:"), i;
+	char *p;
+
+	for (i = 0; i < g->nsymbols; ++i)
+		size += strlen (g->symbol[i]->name) + sizeof ("\tcase TOKEN_:");
+
+	if ((o->text = malloc (size)) == NULL)
+		return 0;
+
+	if ((o->label = malloc (sizeof (o->label[0]) * (nterms + 1))) == NULL)
+		return 0;
+
+	if ((o->nt = malloc (sizeof (o->nt[0]) * (nnt + 1))) == NULL)
+		return 0;
+
+	for (p = o->text, i = 0; i < nterms; ++i)
+		p = frag_make (o->label + i, p, "\tcase TOKEN_",
+			       g->symbol[i]->name, ":");
+
+	p = frag_make (o->label + i, p, "\tcase 0:", "", "");
+
+	for (i = 0; i < nnt; ++i)
+		p = frag_make (o->nt + i, p, "NT_",
+			       g->symbol[nterms + i]->name, "");
+
+	return 1;
 }
 
-static void arrow_code (const struct arrow *a, FILE *f)
+static int code_init (struct code *o, const struct automata *a, FILE *f)
+{
+	const size_t nterms = a->grammar->nterms;
+	size_t i;
+
+	emit_init (&o->out, f);
+
+	o->g = a->grammar;
+	o->text  = NULL;
+	o->label = NULL;
+	o->nt    = NULL;
+	o->stamp = 0;
+	o->empty = 0;
+
+	for (i = 0; i < o->g->nrules; ++i)
+		o->empty |= o->g->rule[i]->prod[0] == NULL;
+
+	bitset_init (&o->closure);
+	bitset_init (&o->shifts);
+	bitset_init (&o->reduces);
+
+	o->reduce  = calloc (a->state.count + 1, sizeof (o->reduce[0]));
+	o->shifted = calloc (nterms + 1, sizeof (o->shifted[0]));
+
+	if (o->reduce == NULL || o->shifted == NULL || !code_names (o))
+		return 0;
+
+	return 1;
+}
+
+static void code_fini (struct code *o)
+{
+	free (o->shifted);
+	free (o->reduce);
+	bitset_fini (&o->reduces);
+	bitset_fini (&o->shifts);
+	bitset_fini (&o->closure);
+	free (o->nt);
+	free (o->label);
+	free (o->text);
+}
+
+static const struct frag *nt_frag (struct code *o, const struct symbol *s)
+{
+	return o->nt + s->id - o->g->nterms;
+}
+
+static void frag_code (struct code *o, const struct frag *f)
+{
+	emit_mem (&o->out, f->s, f->len);
+}
+
+static void arrow_code (struct code *o, const struct arrow *a)
 {
 	if (a->on->rules != NULL)
 		return;
 
-	fprintf (f, "\tcase TOKEN_%s: ret = parse_%zu (c); break;\n",
-		 a->on->name, state_index (a->to));
+	frag_code (o, o->label + a->on->id);
+	emit_lit (&o->out, " ret = parse_");
+	emit_size (&o->out, a->to->index);
+	emit_lit (&o->out, " (c); break;\n");
 }
 
-static void arrow_set_code (const struct ht *s, FILE *f)
+/* marks tokens shifted in the state with new stamp */
+static void mark_shifts (struct code *o, const struct state *s)
 {
 	size_t i;
 	const struct arrow *a;
 
-	fprintf (f, "\n\tswitch (c->lex (c)) {\n");
+	++o->stamp;
 
-	ht_foreach (i, a, s)
-		arrow_code (a, f);
+	ht_foreach (i, a, &s->arrows)
+		if (a->on->rules == NULL)
+			o->shifted[a->on->id] = o->stamp;
+}
+
+/*
+ * Reduce on lookahead tokens which are not shifted: shift wins in
+ * shift/reduce conflict, first reduction wins in reduce/reduce one
+ */
+static void lookahead_set_code (struct code *o, const struct state *s)
+{
+	size_t i, t;
+	const struct lookahead *la;
+	const struct frag *nt;
 
-	fprintf (f, "\tdefault: return -1;\n");
-	fprintf (f, "\t}\n");
+	mark_shifts (o, s);
+
+	ht_foreach (i, la, &s->lookaheads) {
+		if (la->item->rule->prod[la->item->pos] != NULL)
+			continue;
+
+		nt = nt_frag (o, la->item->rule->nt);
+
+		bitset_foreach (t, &la->set) {
+			if (o->shifted[t] == o->stamp)
+				continue;
+
+			o->shifted[t] = o->stamp;
+
+			frag_code (o, o->label + t);
+			emit_lit (&o->out, " c->unlex (c); return ");
+			frag_code (o, nt);
+			emit_lit (&o->out, ";\n");
+		}
+	}
+}
+
+static void arrow_set_code (struct code *o, const struct state *s)
+{
+	size_t i;
+	const struct arrow *a;
+
+	emit_lit (&o->out, "\n\tswitch (c->lex (c)) {\n");
+
+	ht_foreach (i, a, &s->arrows)
+		arrow_code (o, a);
+
+	lookahead_set_code (o, s);
+
+	emit_lit (&o->out, "\tdefault: return -1;\n"
+			   "\t}\n");
 }
 
-static void arrow_nt_code (const struct arrow *a, FILE *f)
+static void arrow_nt_code (struct code *o, const struct arrow *a)
 {
 	if (a->on->rules == NULL)
 		return;
 
-	fprintf (f, "\tcase NT_%s: return parse_%zu (c);\n",
-		 a->on->name, state_index (a->to));
+	emit_lit (&o->out, "\tcase ");
+	frag_code (o, nt_frag (o, a->on));
+	emit_lit (&o->out, ": return parse_");
+	emit_size (&o->out, a->to->index);
+	emit_lit (&o->out, " (c);\n");
 }
 
-static void arrow_set_nt_code (const struct ht *s, FILE *f)
+static void arrow_set_nt_code (struct code *o, const struct ht *s)
 {
 	size_t i;
 	const struct arrow *a;
 
-	fprintf (f, "\n\tswitch (ret) {\n");
+	emit_lit (&o->out, "\n\tswitch (ret) {\n");
 
 	ht_foreach (i, a, s)
-		arrow_nt_code (a, f);
+		arrow_nt_code (o, a);
 
-	fprintf (f, "\tdefault: return -1;\n");
-	fprintf (f, "\t}\n");
+	emit_lit (&o->out, "\tdefault: return -1;\n"
+			   "\t}\n");
 }
 
-static const struct rule *do_reduce (const struct state *s)
+/*
+ * Without empty rules only kernel items can be complete, thus there is
+ * no need to calculate closure
+ */
+static int state_items (struct code *o, const struct state *s)
+{
+	size_t i;
+	const struct item *it;
+
+	if (o->empty)
+		return state_closure (s, &o->closure);
+
+	bitset_clear (&o->closure);
+
+	ht_foreach (i, it, &s->items)
+		if (!bitset_add (&o->closure, it->id))
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Stores the rule to reduce by regardless of lookahead, or NULL if
+ * shift is possible or lookahead should be inspected. Reports conflicts
+ * which lookahead sets (if any) do not resolve.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+static int do_reduce (struct code *o, const struct state *s)
 {
 	const struct rule *rule = NULL;
-	int rr = 0, shift = 0;
+	size_t count = 0;
+	int rr = 0, sr = 0, shift = 0, lookahead = 0;
 	size_t i;
 	const struct item *it;
+	const struct arrow *a;
+	const struct bitset *la;
 
-	ht_foreach (i, it, &s->items) {
-		if (it->rule->prod[it->pos] == NULL) {
-			if (rule != NULL)
-				rr = 1;
+	if (!state_items (o, s))
+		return 0;
 
-			rule = it->rule;
-		}
-		else
+	bitset_clear (&o->shifts);
+	bitset_clear (&o->reduces);
+
+	ht_foreach (i, a, &s->arrows)
+		if (a->on->rules == NULL && !bitset_add (&o->shifts, a->on->id))
+			return 0;
+
+	bitset_foreach (i, &o->closure) {
+		it = s->automata->items + i;
+
+		if (it->rule->prod[it->pos] != NULL) {
 			shift = 1;
+			continue;
+		}
+
+		if ((la = state_lookahead (s, it)) == NULL)
+			rr |= rule != NULL;
+		else {
+			lookahead = 1;
+			rr |= bitset_meet (&o->reduces, la);
+			sr |= bitset_meet (&o->shifts, la);
+
+			if (!bitset_join (&o->reduces, la))
+				return 0;
+		}
+
+		rule = it->rule;
+		++count;
 	}
 
+	if (!lookahead)
+		sr = shift && rule != NULL;
+
 	if (rr)
 		fprintf (stderr, "W: reduce/reduce conflict:\n");
 
-	if (shift && rule != NULL)
+	if (sr)
 		fprintf (stderr, "W: shift/reduce conflict:\n");
 
-	if (rr || (shift && rule != NULL))
-		item_set_show (&s->items, stderr);
+	if (rr || sr)
+		state_items_show (s, stderr);
+
+	if (lookahead)
+		o->reduce[s->index] = !shift && count == 1 ? rule : NULL;
+	else
+		o->reduce[s->index] = shift ? NULL : rule;
 
-	return shift ? NULL : rule;
+	return 1;
 }
 
-void state_code (const struct state *s, FILE *f)
+static void state_code (struct code *o, const struct state *s)
 {
-	const struct rule *rule;
+	const struct rule *rule = o->reduce[s->index];
 
-	fprintf (f, "\nstatic int parse_%zu (struct parser *c)\n{\n",
-		 state_index (s));
+	emit_lit (&o->out, "\nstatic int parse_");
+	emit_size (&o->out, s->index);
+	emit_lit (&o->out, " (struct parser *c)\n{\n");
 
-	if ((rule = do_reduce (s)) != NULL)
-		fprintf (f, "\treturn NT_%s;\n", rule->nt->name);
+	if (rule != NULL) {
+		emit_lit (&o->out, "\treturn ");
+		frag_code (o, nt_frag (o, rule->nt));
+		emit_lit (&o->out, ";\n");
+	}
 	else {
-		fprintf (f, "\tint ret;\n");
+		emit_lit (&o->out, "\tint ret;\n");
 
-		arrow_set_code (&s->arrows, f);
-		arrow_set_nt_code (&s->arrows, f);
+		arrow_set_code (o, s);
+		arrow_set_nt_code (o, &s->arrows);
 
-		fprintf (f, "\n\treturn -1;  /* never be here */\n");
+		emit_lit (&o->out, "\n\treturn -1;  /* never be here */\n");
 	}
 
-	fprintf (f, "}\n");
+	emit_lit (&o->out, "}\n");
 }
 
-void automata_code (const struct automata *o, FILE *f)
+int automata_code (const struct automata *a, FILE *f)
 {
+	struct code *o;
 	size_t i;
-	const struct state *s;
+	int ok;
 
-	if (o->start == NULL)
-		return;
+	if (a->start == NULL)
+		return 1;
+
+	if ((o = malloc (sizeof (*o))) == NULL)
+		return 0;
 
-	ht_foreach (i, s, &o->states)
-		fprintf (f, "static int parse_%zu (struct parser *c);\n",
-			 state_index (s));
+	if (!code_init (o, a, f))
+		goto no_init;
 
-	ht_foreach (i, s, &o->states)
-		state_code (s, f);
+	for (i = 0; i < a->state.count; ++i)
+		if (!do_reduce (o, automata_state (a, i)))
+			goto no_reduce;
+
+	for (i = 0; i < a->state.count; ++i) {
+		emit_lit (&o->out, "static int parse_");
+		emit_size (&o->out, i);
+		emit_lit (&o->out, " (struct parser *c);\n");
+	}
 
-	fprintf (f, "\nint parse (struct parser *c)\n"
-		"{\n"
-		"\treturn parse_%zu (c);\n"
-		"}\n",
-		state_index (o->start));
+	for (i = 0; i < a->state.count; ++i)
+		state_code (o, automata_state (a, i));
+
+	emit_lit (&o->out, "\nint parse (struct parser *c)\n"
+			   "{\n"
+			   "\treturn parse_");
+	emit_size (&o->out, a->start->index);
+	emit_lit (&o->out, " (c);\n"
+			   "}\n");
+
+	ok = emit_fini (&o->out);
+	code_fini (o);
+	free (o);
+	return ok;
+no_reduce:
+no_init:
+	code_fini (o);
+	free (o);
+	return 0;
 }
@@ -0,0 +1,267 @@
+/*
+ * LALR(1) Lookahead Calculation
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include <data/digraph.h>
+#include <parser/automata-lalr.h>
+#include <parser/grammar-first.h>
+
+/*
+ * Non-terminal transition (from, on). The start transition is virtual
+ * when there is no arrow on start symbol from the start state.
+ */
+struct trans {
+	struct state *from;
+	const struct symbol *on;
+	struct state *to;  /* NULL for virtual transition */
+};
+
+/* state q has reduction with lookahead la included in Follow (t) */
+struct lookback {
+	struct lookahead *la;
+	size_t t;
+};
+
+struct lalr {
+	struct automata *a;
+	const struct grammar *g;
+	struct bitset nullable;
+
+	size_t count;         /* number of transitions */
+	size_t start;         /* start transition      */
+	struct trans *trans;
+	struct bitset *F;     /* DR, then Read, then Follow */
+
+	struct relation reads, includes;
+
+	size_t nlookback, size;
+	struct lookback *lookback;
+};
+
+static const struct arrow *
+state_arrow (const struct state *o, const struct symbol *on)
+{
+	struct arrow fake = { on };
+
+	return ht_lookup (&o->arrows, &fake);
+}
+
+static int lalr_add_lookback (struct lalr *o, struct lookahead *la, size_t t)
+{
+	struct lookback *p;
+	size_t size;
+
+	if (o->nlookback >= o->size) {
+		size = o->size == 0 ? 16 : o->size * 2;
+
+		if ((p = realloc (o->lookback, sizeof (p[0]) * size)) == NULL)
+			return 0;
+
+		o->size = size;
+		o->lookback = p;
+	}
+
+	o->lookback[o->nlookback].la = la;
+	o->lookback[o->nlookback].t  = t;
+	++o->nlookback;
+	return 1;
+}
+
+/*
+ * Number non-terminal transitions, the start transition goes last if
+ * it is virtual
+ */
+static int lalr_number (struct lalr *o)
+{
+	struct state *start = (struct state *) o->a->start;
+	size_t i, j;
+	struct state *s;
+	struct arrow *a;
+	const struct arrow *sa;
+
+	o->count = 0;
+
+	for (i = 0; i < o->a->state.count; ++i) {
+		s = automata_state (o->a, i);
+
+		ht_foreach (j, a, &s->arrows)
+			if (a->on->rules != NULL)
+				a->index = o->count++;
+	}
+
+	sa = state_arrow (start, o->g->start);
+
+	if (sa == NULL)
+		++o->count;
+
+	if ((o->trans = malloc (sizeof (o->trans[0]) * o->count)) == NULL)
+		return 0;
+
+	for (i = 0; i < o->a->state.count; ++i) {
+		s = automata_state (o->a, i);
+
+		ht_foreach (j, a, &s->arrows)
+			if (a->on->rules != NULL) {
+				o->trans[a->index].from = s;
+				o->trans[a->index].on   = a->on;
+				o->trans[a->index].to   = a->to;
+			}
+	}
+
+	o->start = sa == NULL ? o->count - 1 : sa->index;
+
+	o->trans[o->start].from = start;
+	o->trans[o->start].on   = o->g->start;
+	o->trans[o->start].to   = sa == NULL ? NULL : sa->to;
+	return 1;
+}
+
+/*
+ * DR (p, A)    = { t | goto (goto (p, A), t) defined }
+ * (p, A) reads (r, C) iff r = goto (p, A) and C is nullable
+ *
+ * End of input follows the start transition.
+ */
+static int lalr_reads (struct lalr *o)
+{
+	size_t t, i;
+	const struct state *r;
+	const struct arrow *a;
+
+	for (t = 0; t < o->count; ++t) {
+		if ((r = o->trans[t].to) == NULL)
+			continue;
+
+		ht_foreach (i, a, &r->arrows) {
+			if (a->on->rules == NULL) {
+				if (!bitset_add (o->F + t, a->on->id))
+					return 0;
+			}
+			else if (bitset_is_member (&o->nullable, a->on->id) &&
+				 !relation_add (&o->reads, t, a->index))
+				return 0;
+		}
+	}
+
+	return bitset_add (o->F + o->start, o->g->nterms);
+}
+
+/*
+ * For transition t = (p, B) and rule B → β A γ, where goto (p, β) = q:
+ *
+ *	(q, A) includes (p, B) iff γ is nullable;
+ *	(q', B → ω) lookback (p, B), where goto (p, ω) = q'.
+ */
+static int lalr_rule (struct lalr *o, size_t t, const struct rule *r)
+{
+	struct state *q = o->trans[t].from;
+	size_t len, tail, i;
+	const struct symbol *x;
+	const struct arrow *a;
+	struct lookahead *la;
+
+	for (len = 0; r->prod[len] != NULL; ++len) {}
+
+	for (
+		tail = len;
+		tail > 0 && bitset_is_member (&o->nullable, r->prod[tail - 1]->id);
+		--tail
+	) {}
+
+	for (i = 0; (x = r->prod[i]) != NULL; ++i) {
+		a = state_arrow (q, x);
+
+		if (x->rules != NULL && i + 1 >= tail &&
+		    !relation_add (&o->includes, a->index, t))
+			return 0;
+
+		q = a->to;
+	}
+
+	la = state_add_lookahead (q, o->a->items + r->item + len);
+
+	return la != NULL && lalr_add_lookback (o, la, t);
+}
+
+static int lalr_includes (struct lalr *o)
+{
+	size_t t, i;
+	const struct rule *r;
+
+	for (t = 0; t < o->count; ++t)
+		ht_foreach (i, r, o->trans[t].on->rules)
+			if (!lalr_rule (o, t, r))
+				return 0;
+
+	return 1;
+}
+
+static int lalr_calc (struct lalr *o)
+{
+	size_t i;
+
+	if (!grammar_nullable (o->g, &o->nullable) || !lalr_number (o))
+		return 0;
+
+	if ((o->F = malloc (sizeof (o->F[0]) * o->count)) == NULL)
+		return 0;
+
+	for (i = 0; i < o->count; ++i)
+		bitset_init (o->F + i);
+
+	if (!lalr_reads (o) || !digraph (&o->reads, o->count, o->F))
+		return 0;
+
+	if (!lalr_includes (o) || !digraph (&o->includes, o->count, o->F))
+		return 0;
+
+	for (i = 0; i < o->nlookback; ++i)
+		if (!bitset_join (&o->lookback[i].la->set,
+				  o->F + o->lookback[i].t))
+			return 0;
+
+	return 1;
+}
+
+int automata_lalr (struct automata *a)
+{
+	struct lalr o;
+	size_t i;
+	int ok;
+
+	if (a->start == NULL || a->grammar->start->rules == NULL)
+		return 1;
+
+	o.a = a;
+	o.g = a->grammar;
+	bitset_init (&o.nullable);
+	o.count = 0;
+	o.trans = NULL;
+	o.F     = NULL;
+	relation_init (&o.reads);
+	relation_init (&o.includes);
+	o.nlookback = 0;
+	o.size      = 0;
+	o.lookback  = NULL;
+
+	ok = lalr_calc (&o);
+
+	free (o.lookback);
+	relation_fini (&o.includes);
+	relation_fini (&o.reads);
+
+	if (o.F != NULL)
+		for (i = 0; i < o.count; ++i)
+			bitset_fini (o.F + i);
+
+	free (o.F);
+	free (o.trans);
+	bitset_fini (&o.nullable);
+	return ok;
+}
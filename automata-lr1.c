@@ -0,0 +1,408 @@
+/*
+ * LR(1) Automata Building
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include <parser/automata-build.h>
+#include <parser/grammar-first.h>
+
+struct lr1 {
+	struct automata *a;
+	const struct grammar *g;
+	struct bitset nullable;
+	struct bitset *first;  /* FIRST sets by symbol id */
+
+	/* closure of current state */
+	struct bitset closure;
+	struct bitset *la;          /* closure lookaheads by non-terminal */
+	size_t *touched, ntouched;  /* non-terminals in closure */
+	struct bitset seen;         /* set of touched non-terminals */
+	size_t *stack, top;         /* propagation worklist */
+	struct bitset pending;      /* set of non-terminals in worklist */
+	struct bitset tmp;
+
+	struct state_seq queue;  /* states to (re)calculate successors */
+};
+
+static void lr1_enqueue (struct lr1 *o, struct state *s)
+{
+	if (s->queued)
+		return;
+
+	s->queued = 1;
+	s->next   = NULL;
+	state_seq_enqueue (&o->queue, s);
+}
+
+static int la_join (struct bitset *o, const struct bitset *s, int *changed)
+{
+	const size_t before = bitset_count (o);
+
+	if (!bitset_join (o, s))
+		return 0;
+
+	*changed = bitset_count (o) != before;
+	return 1;
+}
+
+static int lr1_push (struct lr1 *o, size_t nt)
+{
+	if (bitset_is_member (&o->pending, nt))
+		return 1;
+
+	o->stack[o->top++] = nt;
+	return bitset_add (&o->pending, nt);
+}
+
+static int lr1_touch (struct lr1 *o, size_t nt)
+{
+	if (bitset_is_member (&o->seen, nt))
+		return 1;
+
+	o->touched[o->ntouched++] = nt;
+	return bitset_add (&o->seen, nt) && lr1_push (o, nt);
+}
+
+/* la (B) = la (B) U FIRST (β) U (la if β is nullable) */
+static int lr1_spread (struct lr1 *o, const struct symbol *B,
+		       const struct symbol *const *beta,
+		       const struct bitset *la)
+{
+	const size_t nt = B->id - o->g->nterms;
+	int changed;
+
+	bitset_clear (&o->tmp);
+
+	if (!grammar_seq_first (beta, &o->nullable, o->first, &o->tmp))
+		return 0;
+
+	if (grammar_seq_is_nullable (beta, &o->nullable) &&
+	    !bitset_join (&o->tmp, la))
+		return 0;
+
+	if (!la_join (o->la + nt, &o->tmp, &changed))
+		return 0;
+
+	return !changed || lr1_push (o, nt);
+}
+
+/*
+ * Calculates closure of the state and lookaheads of closure items: for
+ * item A → α • B β with lookahead L every item B → • γ has lookahead
+ * FIRST (β L).
+ */
+static int lr1_closure (struct lr1 *o, const struct state *s)
+{
+	const size_t base = o->g->nterms;
+	size_t i, nt;
+	const struct item *it;
+	const struct symbol *B;
+	const struct rule *r;
+
+	for (i = 0; i < o->ntouched; ++i)
+		bitset_clear (o->la + o->touched[i]);
+
+	o->ntouched = 0;
+	bitset_clear (&o->seen);
+
+	if (!state_closure (s, &o->closure))
+		return 0;
+
+	bitset_foreach (i, &o->closure) {
+		it = o->a->items + i;
+
+		if (it->pos == 0 && !lr1_touch (o, it->rule->nt->id - base))
+			return 0;
+	}
+
+	ht_foreach (i, it, &s->items)
+		if ((B = it->rule->prod[it->pos]) != NULL && B->rules != NULL &&
+		    !lr1_spread (o, B, it->rule->prod + it->pos + 1,
+				 state_lookahead (s, it)))
+			return 0;
+
+	while (o->top > 0) {
+		nt = o->stack[--o->top];
+		bitset_del (&o->pending, nt);
+
+		ht_foreach (i, r, o->g->symbol[nt + base]->rules)
+			if ((B = r->prod[0]) != NULL && B->rules != NULL &&
+			    !lr1_spread (o, B, r->prod + 1, o->la + nt))
+				return 0;
+	}
+
+	return 1;
+}
+
+/* lookahead of kernel or closure item */
+static int lr1_item_la (struct lr1 *o, const struct state *s,
+			const struct item *it, struct bitset *la)
+{
+	const struct bitset *kernel = state_lookahead (s, it);
+
+	bitset_clear (la);
+
+	if (kernel != NULL && !bitset_join (la, kernel))
+		return 0;
+
+	return it->pos != 0 ||
+	       bitset_join (la, o->la + it->rule->nt->id - o->g->nterms);
+}
+
+/*
+ * Pager weak compatibility: for every pair of kernel items i and j of
+ * states p and q with lookaheads P and Q either P(i) ∩ Q(j) and
+ * P(j) ∩ Q(i) are empty or P(i) ∩ P(j) or Q(i) ∩ Q(j) is not empty.
+ */
+static int lr1_is_compatible (const struct state *p, const struct state *q)
+{
+	size_t i, j;
+	const struct item *x, *y;
+	const struct bitset *px, *py, *qx, *qy;
+
+	ht_foreach (i, x, &p->items)
+		ht_foreach (j, y, &p->items) {
+			if (j <= i)
+				continue;
+
+			px = state_lookahead (p, x);
+			py = state_lookahead (p, y);
+			qx = state_lookahead (q, x);
+			qy = state_lookahead (q, y);
+
+			if ((!bitset_meet (px, qy) && !bitset_meet (py, qx)) ||
+			    bitset_meet (px, py) || bitset_meet (qx, qy))
+				continue;
+
+			return 0;
+		}
+
+	return 1;
+}
+
+static int lr1_is_equal (const struct state *p, const struct state *q)
+{
+	size_t i;
+	const struct item *x;
+
+	ht_foreach (i, x, &p->items)
+		if (!bitset_eq (state_lookahead (p, x), state_lookahead (q, x)))
+			return 0;
+
+	return 1;
+}
+
+/* merges lookaheads of q into p, reschedules p if they grow */
+static int lr1_merge (struct lr1 *o, struct state *p, const struct state *q)
+{
+	size_t i;
+	const struct item *x;
+	int changed, grown = 0;
+
+	ht_foreach (i, x, &p->items) {
+		if (!la_join (&state_add_lookahead (p, x)->set,
+			      state_lookahead (q, x), &changed))
+			return 0;
+
+		grown |= changed;
+	}
+
+	if (grown)
+		lr1_enqueue (o, p);
+
+	return 1;
+}
+
+/*
+ * Finds state with the same kernel which can absorb the new state s or
+ * adds s into automata as a new split.
+ */
+static struct state *lr1_add_state (struct lr1 *o, struct state *s)
+{
+	const int canonical = (o->a->flags & AUTOMATA_CANONICAL) != 0;
+	struct state *p;
+
+	for (s->split = 0; (p = ht_lookup (&o->a->states, s)) != NULL;
+	     ++s->split)
+		if (canonical ? lr1_is_equal (p, s) : lr1_is_compatible (p, s))
+			return lr1_merge (o, p, s) ? p : NULL;
+
+	if (!automata_insert_state (o->a, s))
+		return NULL;
+
+	lr1_enqueue (o, s);
+	return s;
+}
+
+/*
+ * Calculates successors of the state. Successor states are created on
+ * the first visit, later visits propagate grown lookaheads only.
+ */
+static int lr1_goto (struct lr1 *o, struct state *s)
+{
+	const int first = s->arrows.count == 0;
+	size_t i;
+	const struct item *it;
+	const struct symbol *X;
+	struct arrow *a;
+	struct lookahead *la;
+	struct state *next;
+	int changed;
+
+	bitset_foreach (i, &o->closure) {
+		it = o->a->items + i;
+
+		if (!lr1_item_la (o, s, it, &o->tmp))
+			return 0;
+
+		if ((X = it->rule->prod[it->pos]) == NULL) {
+			if (it->pos == 0 &&
+			    ((la = state_add_lookahead (s, it)) == NULL ||
+			     !bitset_join (&la->set, &o->tmp)))
+				return 0;
+
+			continue;
+		}
+
+		if ((a = state_add_arrow (s, X)) == NULL ||
+		    (first && !state_add_item (a->to, it->rule, it->pos + 1)) ||
+		    (la = state_add_lookahead (a->to, it + 1)) == NULL ||
+		    !la_join (&la->set, &o->tmp, &changed))
+			return 0;
+
+		if (!first && changed)
+			lr1_enqueue (o, a->to);
+	}
+
+	if (!first)
+		return 1;
+
+	ht_foreach (i, a, &s->arrows) {
+		next = lr1_add_state (o, a->to);
+		if (next != a->to) {
+			state_free (a->to);
+			a->to = next;
+
+			if (next == NULL)
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int lr1_start (struct lr1 *o)
+{
+	struct state *s;
+	size_t i;
+	const struct rule *r;
+	struct lookahead *la;
+
+	if ((s = state_alloc (o->a)) == NULL)
+		return 0;
+
+	if (o->g->start->rules != NULL)
+		ht_foreach (i, r, o->g->start->rules)
+			if (!state_add_item (s, r, 0) ||
+			    (la = state_add_lookahead (s, o->a->items + r->item))
+			    == NULL || !bitset_add (&la->set, o->g->nterms))
+				goto error;
+
+	if (!automata_insert_state (o->a, s))
+		goto error;
+
+	o->a->start = s;
+	lr1_enqueue (o, s);
+	return 1;
+error:
+	state_free (s);
+	return 0;
+}
+
+static int lr1_init (struct lr1 *o, struct automata *a,
+		     const struct grammar *g)
+{
+	const size_t count = g->nsymbols - g->nterms;
+	size_t i;
+
+	o->a = a;
+	o->g = g;
+
+	bitset_init (&o->nullable);
+	bitset_init (&o->closure);
+	bitset_init (&o->seen);
+	bitset_init (&o->pending);
+	bitset_init (&o->tmp);
+
+	o->first   = calloc (g->nsymbols + 1, sizeof (o->first[0]));
+	o->la      = calloc (count + 1, sizeof (o->la[0]));
+	o->touched = malloc (sizeof (o->touched[0]) * (count + 1));
+	o->stack   = malloc (sizeof (o->stack[0]) * (count + 1));
+
+	o->ntouched = 0;
+	o->top      = 0;
+	state_seq_init (&o->queue);
+
+	if (o->first == NULL || o->la == NULL || o->touched == NULL ||
+	    o->stack == NULL)
+		return 0;
+
+	for (i = 0; i < g->nsymbols; ++i)
+		bitset_init (o->first + i);
+
+	for (i = 0; i < count; ++i)
+		bitset_init (o->la + i);
+
+	return grammar_nullable (g, &o->nullable) &&
+	       grammar_first (g, &o->nullable, o->first);
+}
+
+static void lr1_fini (struct lr1 *o)
+{
+	const size_t count = o->g->nsymbols - o->g->nterms;
+	size_t i;
+
+	if (o->first != NULL)
+		for (i = 0; i < o->g->nsymbols; ++i)
+			bitset_fini (o->first + i);
+
+	if (o->la != NULL)
+		for (i = 0; i < count; ++i)
+			bitset_fini (o->la + i);
+
+	free (o->first);
+	free (o->la);
+	free (o->touched);
+	free (o->stack);
+
+	bitset_fini (&o->nullable);
+	bitset_fini (&o->closure);
+	bitset_fini (&o->seen);
+	bitset_fini (&o->pending);
+	bitset_fini (&o->tmp);
+}
+
+int automata_build_lr1 (struct automata *a, const struct grammar *g)
+{
+	struct lr1 o;
+	struct state *s;
+	int ok;
+
+	if (!automata_prepare (a, g))
+		return 0;
+
+	ok = lr1_init (&o, a, g) && lr1_start (&o);
+
+	while (ok && (s = state_seq_dequeue (&o.queue)) != NULL) {
+		s->queued = 0;
+		ok = lr1_closure (&o, s) && lr1_goto (&o, s);
+	}
+
+	lr1_fini (&o);
+	return ok;
+}
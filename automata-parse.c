@@ -0,0 +1,116 @@
+/*
+ * LR Parser Runtime
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <parser/automata-parse.h>
+
+int automata_parser_init (struct automata_parser *o,
+			  const struct automata_table *t)
+{
+	o->table  = t;
+	o->size   = 64;
+	o->lex    = NULL;
+	o->reduce = NULL;
+	o->cookie = NULL;
+
+	o->state = malloc (sizeof (o->state[0]) * o->size);
+	o->value = malloc (sizeof (o->value[0]) * o->size);
+
+	if (o->state == NULL || o->value == NULL) {
+		automata_parser_fini (o);
+		return 0;
+	}
+
+	return 1;
+}
+
+void automata_parser_fini (struct automata_parser *o)
+{
+	free (o->state);
+	free (o->value);
+}
+
+static int parser_grow (struct automata_parser *o)
+{
+	const size_t size = o->size * 2;
+	size_t *state;
+	void **value;
+
+	if ((state = realloc (o->state, sizeof (state[0]) * size)) == NULL)
+		return 0;
+
+	o->state = state;
+
+	if ((value = realloc (o->value, sizeof (value[0]) * size)) == NULL)
+		return 0;
+
+	o->value = value;
+	o->size  = size;
+	return 1;
+}
+
+int automata_parse (struct automata_parser *o, void **result)
+{
+	const struct automata_table *t = o->table;
+	size_t top = 0, s, r, nt;
+	void *value = NULL;
+	int token, a;
+
+	o->state[0] = t->start;
+	o->value[0] = NULL;
+
+	if ((token = o->lex (o->cookie, &value)) < 0)
+		goto error;
+
+	while ((a = automata_table_action (t, o->state[top], token)) != 0) {
+		if (a > 0) {
+			s = a - 1;
+
+			if (top + 1 >= o->size && !parser_grow (o))
+				return 0;
+
+			o->state[++top] = s;
+			o->value[top]   = value;
+			value = NULL;
+
+			if ((token = o->lex (o->cookie, &value)) < 0)
+				goto error;
+
+			continue;
+		}
+
+		r  = -a - 1;
+		top -= t->rule_len[r];
+		nt = t->rule_nt[r];
+
+		if (top + 1 >= o->size && !parser_grow (o))
+			return 0;
+
+		o->value[top + 1] = o->reduce == NULL ? NULL :
+			o->reduce (o->cookie, t->grammar->rule[r],
+				   o->value + top + 1);
+
+		if (top == 0 && nt == t->accept && token == t->nterms) {
+			if (result != NULL)
+				*result = o->value[1];
+
+			return 1;
+		}
+
+		if ((s = automata_table_goto (t, o->state[top], nt)) >=
+		    t->nstates)
+			break;
+
+		o->state[++top] = s;
+	}
+error:
+	errno = EINVAL;
+	return 0;
+}
@@ -13,7 +13,7 @@ static void marker_show (FILE *f)
 	fprintf (f, " •");
 }
 
-void item_show (const struct item *o, FILE *f)
+static void item_line_show (const struct item *o, FILE *f)
 {
 	size_t i;
 	const struct rule *r;
@@ -27,7 +27,11 @@ void item_show (const struct item *o, FILE *f)
 
 	for (; r->prod[i] != NULL; ++i)
 		fprintf (f, " %s", r->prod[i]->name);
+}
 
+void item_show (const struct item *o, FILE *f)
+{
+	item_line_show (o, f);
 	fprintf (f, "\n");
 }
 
@@ -42,9 +46,7 @@ void item_set_show (const struct ht *o, FILE *f)
 
 void arrow_show (const struct arrow *o, FILE *f)
 {
-	size_t i = ht_index (&o->to->automata->states, o->to);
-
-	fprintf (f, "  %s → %zu\n", o->on->name, i);
+	fprintf (f, "  %s → %zu\n", o->on->name, o->to->index);
 }
 
 void arrow_set_show (const struct ht *o, FILE *f)
@@ -56,21 +58,59 @@ void arrow_set_show (const struct ht *o, FILE *f)
 		arrow_show (a, f);
 }
 
+/* shows kernel and closure items of the state */
+void state_items_show (const struct state *o, FILE *f)
+{
+	struct bitset closure;
+	size_t i;
+
+	bitset_init (&closure);
+
+	if (state_closure (o, &closure))
+		bitset_foreach (i, &closure)
+			item_show (o->automata->items + i, f);
+
+	bitset_fini (&closure);
+}
+
+void lookahead_show (const struct lookahead *o, const struct grammar *g,
+		     FILE *f)
+{
+	size_t t;
+
+	item_line_show (o->item, f);
+	fprintf (f, "  [");
+
+	bitset_foreach (t, &o->set)
+		fprintf (f, " %s", t == g->nterms ? "$" : g->symbol[t]->name);
+
+	fprintf (f, " ]\n");
+}
+
 void state_show (const struct state *o, FILE *f)
 {
-	size_t i = ht_index (&o->automata->states, o);
+	const size_t i = o->index;
+	size_t j;
+	const struct lookahead *la;
 
 	fprintf (f, "state %zu:\n", i);
-	item_set_show (&o->items, f);
+	state_items_show (o, f);
 	fprintf (f, "arrows from %zu:\n", i);
 	arrow_set_show (&o->arrows, f);
+
+	if (o->lookaheads.count == 0)
+		return;
+
+	fprintf (f, "lookaheads in %zu:\n", i);
+
+	ht_foreach (j, la, &o->lookaheads)
+		lookahead_show (la, o->automata->grammar, f);
 }
 
 void automata_show (const struct automata *o, FILE *f)
 {
 	size_t i;
-	const struct state *s;
 
-	ht_foreach (i, s, &o->states)
-		state_show (s, f);
+	for (i = 0; i < o->state.count; ++i)
+		state_show (automata_state (o, i), f);
 }
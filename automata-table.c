@@ -0,0 +1,730 @@
+/*
+ * Compressed LR Parsing Tables
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <parser/automata-table.h>
+
+/* non-default entry of a row */
+struct cell {
+	size_t col;
+	int value;
+};
+
+struct table {
+	struct automata_table *o;
+	const struct automata *a;
+
+	size_t ncells, size;
+	struct cell *cell;            /* non-default entries by row     */
+	size_t *row;                  /* first cell of row, nrows + 1   */
+
+	int *line;                    /* ACTION row of current state    */
+	size_t *touched, ntouched;    /* non-error columns of the row   */
+	size_t *freq;                 /* frequencies of values          */
+
+	size_t *skip;                 /* next free slot candidate       */
+};
+
+static int table_add_cell (struct table *o, size_t col, int value)
+{
+	struct cell *p;
+	size_t size;
+
+	if (o->ncells >= o->size) {
+		size = o->size == 0 ? 64 : o->size * 2;
+
+		if ((p = realloc (o->cell, sizeof (p[0]) * size)) == NULL)
+			return 0;
+
+		o->cell = p;
+		o->size = size;
+	}
+
+	o->cell[o->ncells].col   = col;
+	o->cell[o->ncells].value = value;
+	++o->ncells;
+	return 1;
+}
+
+static int cell_cmp (const void *a, const void *b)
+{
+	const struct cell *x = a, *y = b;
+
+	return x->col < y->col ? -1 : x->col > y->col;
+}
+
+static int reduce (const struct rule *r)
+{
+	return -(int) r->id - 1;
+}
+
+static void table_set (struct table *o, size_t t, int value)
+{
+	if (o->line[t] != 0)
+		return;
+
+	o->line[t] = value;
+	o->touched[o->ntouched++] = t;
+}
+
+/* returns the most frequent reduction of the current ACTION row */
+static int table_default (struct table *o)
+{
+	size_t i, r, max = 0;
+	int value = 0;
+
+	for (i = 0; i < o->ntouched; ++i)
+		if (o->line[o->touched[i]] < 0) {
+			r = -o->line[o->touched[i]] - 1;
+
+			if (++o->freq[r] > max) {
+				max = o->freq[r];
+				value = o->line[o->touched[i]];
+			}
+		}
+
+	for (i = 0; i < o->ntouched; ++i)
+		if (o->line[o->touched[i]] < 0)
+			o->freq[-o->line[o->touched[i]] - 1] = 0;
+
+	return value;
+}
+
+/* returns the only reduction of the state, or NULL if there are more */
+static const struct rule *
+table_only (const struct table *o, const struct bitset *closure)
+{
+	size_t i;
+	const struct item *it;
+	const struct rule *rule = NULL;
+
+	bitset_foreach (i, closure) {
+		it = o->a->items + i;
+
+		if (it->rule->prod[it->pos] != NULL)
+			continue;
+
+		if (rule != NULL)
+			return NULL;
+
+		rule = it->rule;
+	}
+
+	return rule;
+}
+
+/*
+ * Fills ACTION row of the state: shift wins in shift/reduce conflict,
+ * first reduction wins in reduce/reduce one. The only reduction of the
+ * state or reduction without lookahead set becomes the default action
+ * without expansion of its lookaheads.
+ */
+static int table_state (struct table *o, size_t n, struct bitset *closure)
+{
+	const struct state *s = automata_state (o->a, n);
+	size_t i, t, first = o->ncells;
+	const struct arrow *a;
+	const struct item *it;
+	const struct bitset *la;
+	const struct rule *lr0;
+	int def, ok = 1;
+
+	o->ntouched = 0;
+
+	ht_foreach (i, a, &s->arrows)
+		if (a->on->rules == NULL)
+			table_set (o, a->on->id, a->to->index + 1);
+
+	if (!state_closure (s, closure))
+		return 0;
+
+	if ((lr0 = table_only (o, closure)) == NULL)
+		bitset_foreach (i, closure) {
+			it = o->a->items + i;
+
+			if (it->rule->prod[it->pos] != NULL)
+				continue;
+
+			if ((la = state_lookahead (s, it)) == NULL) {
+				if (lr0 == NULL)
+					lr0 = it->rule;
+
+				continue;
+			}
+
+			bitset_foreach (t, la)
+				table_set (o, t, reduce (it->rule));
+		}
+
+	def = lr0 != NULL ? reduce (lr0) : table_default (o);
+	o->o->defact[n] = def;
+
+	for (i = 0; i < o->ntouched; ++i) {
+		t = o->touched[i];
+
+		if (ok && o->line[t] != def)
+			ok = table_add_cell (o, t, o->line[t]);
+
+		o->line[t] = 0;
+	}
+
+	qsort (o->cell + first, o->ncells - first, sizeof (o->cell[0]),
+	       cell_cmp);
+	return ok;
+}
+
+static int table_actions (struct table *o)
+{
+	struct bitset closure;
+	size_t n;
+	int ok = 1;
+
+	bitset_init (&closure);
+
+	for (n = 0; ok && n < o->o->nstates; ++n) {
+		o->row[n] = o->ncells;
+		ok = table_state (o, n, &closure);
+	}
+
+	bitset_fini (&closure);
+	return ok;
+}
+
+/*
+ * Fills GOTO columns: transitions are grouped by non-terminal in order
+ * of states, the most frequent target becomes the default one.
+ */
+static int table_gotos (struct table *o)
+{
+	struct automata_table *t = o->o;
+	const size_t nnt = t->nsymbols - t->nterms;
+	size_t *start, i, k, n, to, max;
+	struct cell *g;
+	const struct arrow *a;
+	int ok = 0;
+
+	if ((start = calloc (nnt + 1, sizeof (start[0]))) == NULL)
+		return 0;
+
+	for (n = 0; n < t->nstates; ++n)
+		ht_foreach (i, a, &automata_state (o->a, n)->arrows)
+			if (a->on->rules != NULL)
+				++start[a->on->id - t->nterms + 1];
+
+	for (k = 0; k < nnt; ++k)
+		start[k + 1] += start[k];
+
+	if ((g = malloc (sizeof (g[0]) * (start[nnt] + 1))) == NULL)
+		goto no_cells;
+
+	for (n = 0; n < t->nstates; ++n)
+		ht_foreach (i, a, &automata_state (o->a, n)->arrows)
+			if (a->on->rules != NULL) {
+				k = start[a->on->id - t->nterms]++;
+				g[k].col   = n;
+				g[k].value = a->to->index;
+			}
+
+	/* start[k] now points to the end of column k */
+	for (k = nnt; k > 0; --k)
+		start[k] = start[k - 1];
+
+	start[0] = 0;
+
+	for (k = 0; k < nnt; ++k) {
+		t->defgoto[k] = t->nstates;
+
+		for (max = 0, i = start[k]; i < start[k + 1]; ++i)
+			if (++o->freq[to = g[i].value] > max) {
+				max = o->freq[to];
+				t->defgoto[k] = to;
+			}
+
+		o->row[t->nstates + k] = o->ncells;
+
+		for (i = start[k]; i < start[k + 1]; ++i) {
+			o->freq[g[i].value] = 0;
+
+			if (g[i].value != t->defgoto[k] &&
+			    !table_add_cell (o, g[i].col, g[i].value))
+				goto no_add;
+		}
+	}
+
+	o->row[t->nrows] = o->ncells;
+	ok = 1;
+no_add:
+	free (g);
+no_cells:
+	free (start);
+	return ok;
+}
+
+static int table_grow (struct table *o, size_t need)
+{
+	struct automata_table *t = o->o;
+	size_t size, i, *check, *skip;
+	int *value;
+
+	if (need <= t->size)
+		return 1;
+
+	for (size = t->size == 0 ? 256 : t->size * 2; size < need;
+	     size *= 2) {}
+
+	if ((check = realloc (t->check, sizeof (check[0]) * size)) == NULL)
+		return 0;
+
+	t->check = check;
+
+	if ((value = realloc (t->value, sizeof (value[0]) * size)) == NULL)
+		return 0;
+
+	t->value = value;
+
+	if ((skip = realloc (o->skip, sizeof (skip[0]) * size)) == NULL)
+		return 0;
+
+	o->skip = skip;
+
+	for (i = t->size; i < size; ++i) {
+		t->check[i] = SIZE_MAX;
+		t->value[i] = 0;
+		o->skip[i]  = i;
+	}
+
+	t->size = size;
+	return 1;
+}
+
+/*
+ * Returns the first free slot starting from i. Occupied slots point to
+ * the next candidate, paths are compressed on the way (as in
+ * union-find), thus dense prefix of the comb vector is skipped fast.
+ */
+static size_t table_free (struct table *o, size_t i)
+{
+	const size_t size = o->o->size;
+	size_t root, next;
+
+	for (root = i; root < size && o->skip[root] != root; )
+		root = o->skip[root];
+
+	for (; i < size && o->skip[i] != i; i = next) {
+		next = o->skip[i];
+		o->skip[i] = root;
+	}
+
+	return root;
+}
+
+/*
+ * Places row at the first displacement not less than from where all its
+ * entries fall into free slots of the comb vector.
+ */
+static int table_place (struct table *o, size_t r, size_t from)
+{
+	struct automata_table *t = o->o;
+	const struct cell *c = o->cell + o->row[r];
+	const size_t n = o->row[r + 1] - o->row[r];
+	size_t base, pos, i, j;
+
+	t->base[r] = 0;
+
+	if (n == 0)
+		return 1;
+
+	for (pos = table_free (o, from + c[0].col);;
+	     pos = table_free (o, pos + 1)) {
+		base = pos - c[0].col;
+
+		for (j = 1; j < n; ++j) {
+			i = base + c[j].col;
+
+			if (i < t->size && t->check[i] != SIZE_MAX)
+				break;
+		}
+
+		if (j == n)
+			break;
+	}
+
+	if (!table_grow (o, base + c[n - 1].col + 1))
+		return 0;
+
+	for (j = 0; j < n; ++j) {
+		i = base + c[j].col;
+		t->check[i] = r;
+		t->value[i] = c[j].value;
+		o->skip[i]  = i + 1;
+	}
+
+	t->base[r] = base;
+	t->entries += n;
+	return 1;
+}
+
+struct shape {
+	const struct cell *c;
+	size_t n, row;
+};
+
+/* compares columns of rows relative to their first columns */
+static int shape_cmp (const struct shape *x, const struct shape *y)
+{
+	size_t j, a, b;
+
+	if (x->n != y->n)
+		return x->n > y->n ? -1 : 1;
+
+	for (j = 1; j < x->n; ++j) {
+		a = x->c[j].col - x->c[0].col;
+		b = y->c[j].col - y->c[0].col;
+
+		if (a != b)
+			return a < b ? -1 : 1;
+	}
+
+	return 0;
+}
+
+static int row_cmp (const void *a, const void *b)
+{
+	const struct shape *x = a, *y = b;
+	const int ret = shape_cmp (x, y);
+
+	if (ret != 0)
+		return ret;
+
+	return x->row < y->row ? -1 : x->row > y->row;
+}
+
+/*
+ * Places rows in order of decreasing number of entries. Rows of the
+ * same shape are placed in a row: slots are never freed, thus the
+ * search for the next one starts right after the previous base.
+ */
+static int table_pack (struct table *o)
+{
+	const size_t nrows = o->o->nrows;
+	struct shape *order;
+	size_t r, from;
+	int ok = 1;
+
+	if ((order = malloc (sizeof (order[0]) * (nrows + 1))) == NULL)
+		return 0;
+
+	for (r = 0; r < nrows; ++r) {
+		order[r].c   = o->cell + o->row[r];
+		order[r].n   = o->row[r + 1] - o->row[r];
+		order[r].row = r;
+	}
+
+	qsort (order, nrows, sizeof (order[0]), row_cmp);
+
+	for (r = 0; ok && r < nrows; ++r) {
+		from = r > 0 && order[r].n > 0 &&
+		       shape_cmp (order + r - 1, order + r) == 0 ?
+		       o->o->base[order[r - 1].row] + 1 : 0;
+
+		ok = table_place (o, order[r].row, from);
+	}
+
+	/* drop free tail of the vector */
+	while (o->o->size > 0 && o->o->check[o->o->size - 1] == SIZE_MAX)
+		--o->o->size;
+
+	free (order);
+	return ok;
+}
+
+static void table_rules (struct automata_table *o)
+{
+	const struct grammar *g = o->grammar;
+	size_t i, len;
+	const struct rule *r;
+
+	for (i = 0; i < g->nrules; ++i) {
+		r = g->rule[i];
+
+		for (len = 0; r->prod[len] != NULL; ++len) {}
+
+		o->rule_nt[i]  = r->nt->id - g->nterms;
+		o->rule_len[i] = len;
+	}
+
+	o->accept = g->start == NULL ? 0 : g->start->id - g->nterms;
+}
+
+static void automata_table_zero (struct automata_table *o)
+{
+	o->rule_nt  = NULL;
+	o->rule_len = NULL;
+	o->defact   = NULL;
+	o->defgoto  = NULL;
+	o->base     = NULL;
+	o->value    = NULL;
+	o->check    = NULL;
+	o->size     = 0;
+	o->entries  = 0;
+}
+
+int automata_table_init (struct automata_table *o, const struct automata *a)
+{
+	const struct grammar *g = a->grammar;
+	const size_t nstates = a->states.count;
+	struct table t;
+	int ok = 0;
+
+	automata_table_zero (o);
+
+	if (g == NULL || g->rule == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	o->grammar  = g;
+	o->nterms   = g->nterms;
+	o->nsymbols = g->nsymbols;
+	o->nrules   = g->nrules;
+	o->nstates  = nstates;
+	o->nrows    = nstates + g->nsymbols - g->nterms;
+	o->start    = a->start == NULL ? 0 : a->start->index;
+
+	o->rule_nt  = malloc (sizeof (o->rule_nt[0])  * (g->nrules + 1));
+	o->rule_len = malloc (sizeof (o->rule_len[0]) * (g->nrules + 1));
+	o->defact   = malloc (sizeof (o->defact[0])   * (nstates + 1));
+	o->defgoto  = malloc (sizeof (o->defgoto[0])  *
+			      (g->nsymbols - g->nterms + 1));
+	o->base     = malloc (sizeof (o->base[0])     * (o->nrows + 1));
+
+	t.o = o;
+	t.a = a;
+	t.ncells = 0;
+	t.size   = 0;
+	t.cell   = NULL;
+	t.skip   = NULL;
+
+	t.row     = malloc (sizeof (t.row[0])     * (o->nrows + 1));
+	t.line    = calloc (g->nterms + 1, sizeof (t.line[0]));
+	t.touched = malloc (sizeof (t.touched[0]) * (g->nterms + 1));
+	t.freq    = calloc (nstates + g->nrules + 1, sizeof (t.freq[0]));
+
+	if (o->rule_nt == NULL || o->rule_len == NULL || o->defact == NULL ||
+	    o->defgoto == NULL || o->base == NULL || t.row == NULL || t.line == NULL ||
+	    t.touched == NULL || t.freq == NULL)
+		goto error;
+
+	table_rules (o);
+
+	ok = table_actions (&t) && table_gotos (&t) &&
+	     table_pack (&t);
+error:
+	free (t.row);
+	free (t.line);
+	free (t.touched);
+	free (t.freq);
+	free (t.cell);
+	free (t.skip);
+
+	if (!ok)
+		automata_table_fini (o);
+
+	return ok;
+}
+
+void automata_table_fini (struct automata_table *o)
+{
+	free (o->rule_nt);
+	free (o->rule_len);
+	free (o->defact);
+	free (o->defgoto);
+	free (o->base);
+	free (o->value);
+	free (o->check);
+
+	automata_table_zero (o);
+}
+
+/* returns the narrowest C type which holds values from min to max */
+static const char *int_type (long min, long max)
+{
+	if (min >= 0)
+		return max <= UINT8_MAX  ? "unsigned char"  :
+		       max <= UINT16_MAX ? "unsigned short" : "unsigned";
+
+	return min >= INT8_MIN  && max <= INT8_MAX  ? "signed char" :
+	       min >= INT16_MIN && max <= INT16_MAX ? "short" : "int";
+}
+
+static void array_code (const char *name, const long *v, size_t count,
+			FILE *f)
+{
+	long min = 0, max = 0;
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		min = v[i] < min ? v[i] : min;
+		max = v[i] > max ? v[i] : max;
+	}
+
+	fprintf (f, "\nstatic const %s %s[] = {", int_type (min, max), name);
+
+	for (i = 0; i < count; ++i)
+		fprintf (f, "%s%ld,", i % 12 == 0 ? "\n\t" : " ", v[i]);
+
+	fprintf (f, "\n};\n");
+}
+
+static int size_array_code (const char *name, const size_t *v,
+			     size_t count, long none, FILE *f)
+{
+	long *p;
+	size_t i;
+
+	if ((p = malloc (sizeof (p[0]) * (count + 1))) == NULL)
+		return 0;
+
+	for (i = 0; i < count; ++i)
+		p[i] = v[i] == SIZE_MAX ? none : (long) v[i];
+
+	array_code (name, p, count, f);
+	free (p);
+	return 1;
+}
+
+static int int_array_code (const char *name, const int *v, size_t count,
+			    FILE *f)
+{
+	long *p;
+	size_t i;
+
+	if ((p = malloc (sizeof (p[0]) * (count + 1))) == NULL)
+		return 0;
+
+	for (i = 0; i < count; ++i)
+		p[i] = v[i];
+
+	array_code (name, p, count, f);
+	free (p);
+	return 1;
+}
+
+static void token_map_code (const struct automata_table *o, FILE *f)
+{
+	const struct grammar *g = o->grammar;
+	size_t i;
+
+	fprintf (f, "\nstatic int parse_token (int token)\n"
+		    "{\n"
+		    "\tswitch (token) {\n"
+		    "\tcase 0: return %zu;\n", g->nterms);
+
+	for (i = 0; i < g->nterms; ++i)
+		fprintf (f, "\tcase TOKEN_%s: return %zu;\n",
+			 g->symbol[i]->name, i);
+
+	fprintf (f, "\tdefault: return -1;\n"
+		    "\t}\n"
+		    "}\n");
+}
+
+static const char *driver_code =
+	"\nstatic int parse_action (size_t s, int t)\n"
+	"{\n"
+	"\tconst size_t i = parse_base[s] + t;\n"
+	"\n"
+	"\treturn i < PARSE_SIZE && parse_check[i] == s ?\n"
+	"\t       parse_value[i] : parse_defact[s];\n"
+	"}\n"
+	"\n"
+	"static size_t parse_goto (size_t s, size_t nt)\n"
+	"{\n"
+	"\tconst size_t r = PARSE_STATES + nt, i = parse_base[r] + s;\n"
+	"\n"
+	"\treturn i < PARSE_SIZE && parse_check[i] == r ?\n"
+	"\t       (size_t) parse_value[i] : parse_defgoto[nt];\n"
+	"}\n"
+	"\n"
+	"int parse (struct parser *c)\n"
+	"{\n"
+	"\tsize_t size = 64, top = 0, *stack, *p, s, nt;\n"
+	"\tint t, a, ret = -1;\n"
+	"\n"
+	"\tif ((stack = malloc (sizeof (stack[0]) * size)) == NULL)\n"
+	"\t\treturn -1;\n"
+	"\n"
+	"\tstack[0] = PARSE_START;\n"
+	"\tt = parse_token (c->lex (c));\n"
+	"\n"
+	"\twhile (t >= 0 && (a = parse_action (stack[top], t)) != 0) {\n"
+	"\t\tif (a > 0) {\n"
+	"\t\t\ts = a - 1;\n"
+	"\t\t\tt = parse_token (c->lex (c));\n"
+	"\t\t}\n"
+	"\t\telse {\n"
+	"\t\t\ttop -= parse_rule_len[-a - 1];\n"
+	"\t\t\tnt = parse_rule_nt[-a - 1];\n"
+	"\n"
+	"\t\t\tif (top == 0 && nt == PARSE_ACCEPT && t == PARSE_EOI) {\n"
+	"\t\t\t\tret = PARSE_RESULT;\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t\t}\n"
+	"\n"
+	"\t\t\tif ((s = parse_goto (stack[top], nt)) >= PARSE_STATES)\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\tif (++top >= size) {\n"
+	"\t\t\tif ((p = realloc (stack, sizeof (p[0]) * size * 2)) == NULL)\n"
+	"\t\t\t\tbreak;\n"
+	"\n"
+	"\t\t\tstack = p;\n"
+	"\t\t\tsize *= 2;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\tstack[top] = s;\n"
+	"\t}\n"
+	"\n"
+	"\tfree (stack);\n"
+	"\treturn ret;\n"
+	"}\n";
+
+int automata_table_code (const struct automata_table *o, FILE *f)
+{
+	const struct grammar *g = o->grammar;
+
+	fprintf (f, "#include <stdlib.h>\n\n");
+
+	fprintf (f, "#define PARSE_STATES  %zu\n", o->nstates);
+	fprintf (f, "#define PARSE_START   %zu\n", o->start);
+	fprintf (f, "#define PARSE_ACCEPT  %zu\n", o->accept);
+	fprintf (f, "#define PARSE_EOI     %zu\n", o->nterms);
+	fprintf (f, "#define PARSE_SIZE    %zu\n", o->size);
+
+	if (g->start != NULL)
+		fprintf (f, "#define PARSE_RESULT  NT_%s\n", g->start->name);
+
+	if (!size_array_code ("parse_rule_nt",  o->rule_nt,  o->nrules, 0, f) ||
+	    !size_array_code ("parse_rule_len", o->rule_len, o->nrules, 0, f) ||
+	    !int_array_code  ("parse_defact",   o->defact,   o->nstates, f) ||
+	    !size_array_code ("parse_defgoto",  o->defgoto,
+			      o->nsymbols - o->nterms, 0, f) ||
+	    !size_array_code ("parse_base",  o->base,  o->nrows, 0, f) ||
+	    !size_array_code ("parse_check", o->check, o->size, o->nrows, f) ||
+	    !int_array_code  ("parse_value", o->value, o->size, f))
+		return 0;
+
+	token_map_code (o, f);
+	fputs (driver_code, f);
+
+	return fflush (f) == 0 && !ferror (f);
+}
@@ -6,40 +6,33 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <errno.h>
 #include <stdlib.h>
 
+#include <data/arena.h>
 #include <data/atom.h>
+#include <data/digraph.h>
 #include <data/hash.h>
 #include <parser/automata.h>
 
 /*
- * Automata Item type
+ * Automata Item type: items are unique, see automata_prepare
  */
 
-static int item_eq (const void *a, const void *b)
-{
-	const struct item *p = a;
-	const struct item *q = b;
-
-	return atom_eq (p->rule, q->rule) && p->pos == q->pos;
-}
-
 static size_t item_hash (const void *o)
 {
 	const struct item *p = o;
 
-	return hash (hash (0, &p->rule, sizeof (p->rule)),
-		     &p->pos, sizeof (p->pos));
+	return hash_mix (p->id);
 }
 
 static const struct data_type item_type = {
-	.free	= free,
-	.eq	= item_eq,
+	.eq	= atom_eq,
 	.hash	= item_hash,
 };
 
 /*
- * State Arrow type
+ * State Arrow type: arrows are owned by automata arena
  */
 
 static int arrow_eq (const void *a, const void *b)
@@ -54,38 +47,83 @@ static size_t arrow_hash (const void *o)
 {
 	const struct arrow *p = o;
 
-	return atom_hash (p->on);
+	return p->on->id;
 }
 
 static const struct data_type arrow_type = {
-	.free	= free,
 	.eq	= arrow_eq,
 	.hash	= arrow_hash,
 };
 
 /*
- * State
+ * State Lookahead type: lookaheads are owned by automata arena
+ */
+
+static void lookahead_free (void *o)
+{
+	struct lookahead *p = o;
+
+	if (p != NULL)
+		bitset_fini (&p->set);
+}
+
+static int lookahead_eq (const void *a, const void *b)
+{
+	const struct lookahead *p = a;
+	const struct lookahead *q = b;
+
+	return atom_eq (p->item, q->item);
+}
+
+static size_t lookahead_hash (const void *o)
+{
+	const struct lookahead *p = o;
+
+	return item_hash (p->item);
+}
+
+static const struct data_type lookahead_type = {
+	.free	= lookahead_free,
+	.eq	= lookahead_eq,
+	.hash	= lookahead_hash,
+};
+
+/*
+ * State: states are owned by automata arena, freed states are reused
  */
 
 struct state *state_alloc (struct automata *a)
 {
 	struct state *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	if ((o = a->spare) != NULL)
+		a->spare = o->next;
+	else if ((o = arena_alloc (&a->arena, sizeof (*o))) == NULL)
 		goto no_state;
 
-	if (!ht_init (&o->items, &atom_type))
+	if (!ht_init (&o->items, &item_type))
 		goto no_items;
 
 	if (!ht_init (&o->arrows, &arrow_type))
 		goto no_arrows;
 
+	if (!ht_init (&o->lookaheads, &lookahead_type))
+		goto no_lookaheads;
+
+	bitset_init (&o->set);
+
+	o->next     = NULL;
+	o->queued   = 0;
+	o->split    = 0;
 	o->automata = a;
 	return o;
+no_lookaheads:
+	ht_fini (&o->arrows);
 no_arrows:
 	ht_fini (&o->items);
 no_items:
-	free (o);
+	o->next  = a->spare;
+	a->spare = o;
 no_state:
 	return NULL;
 }
@@ -98,7 +136,12 @@ void state_free (void *o)
 		return;
 
 	ht_fini (&s->items);
+	bitset_fini (&s->set);
 	ht_fini (&s->arrows);
+	ht_fini (&s->lookaheads);
+
+	s->next = s->automata->spare;
+	s->automata->spare = s;
 }
 
 static int state_eq (const void *a, const void *b)
@@ -106,6 +149,12 @@ static int state_eq (const void *a, const void *b)
 	const struct state *p = a;
 	const struct state *q = b;
 
+	if (p->split != q->split)
+		return 0;
+
+	if ((p->automata->flags & AUTOMATA_BITSET) != 0)
+		return bitset_eq (&p->set, &q->set);
+
 	return ht_eq (&p->items, &q->items);
 }
 
@@ -113,7 +162,10 @@ static size_t state_hash (const void *o)
 {
 	const struct state *p = o;
 
-	return ht_hash (&p->items);
+	if ((p->automata->flags & AUTOMATA_BITSET) != 0)
+		return bitset_hash (&p->set) + p->split;
+
+	return ht_hash (&p->items) + p->split;
 }
 
 static const struct data_type state_type = {
@@ -129,7 +181,29 @@ int state_add_item (struct state *o, const struct rule *rule, size_t pos)
 	if ((item = automata_add_item (o->automata, rule, pos)) == NULL)
 		return 0;
 
-	return ht_insert (&o->items, (void *) item);
+	if ((o->automata->flags & AUTOMATA_BITSET) == 0)
+		return ht_insert (&o->items, (void *) item);
+
+	if (bitset_is_member (&o->set, item->id)) {
+		errno = EEXIST;
+		return 0;
+	}
+
+	return bitset_add (&o->set, item->id) &&
+	       ht_insert (&o->items, (void *) item);
+}
+
+int state_add_items (struct state *o, const struct item **items,
+		     size_t count)
+{
+	size_t i;
+
+	if ((o->automata->flags & AUTOMATA_BITSET) != 0)
+		for (i = count; i > 0; --i)  /* grow set once for sorted ids */
+			if (!bitset_add (&o->set, items[i - 1]->id))
+				return 0;
+
+	return ht_insert_many (&o->items, (void **) items, count);
 }
 
 struct arrow *state_add_arrow (struct state *o, const struct symbol *on)
@@ -139,23 +213,75 @@ struct arrow *state_add_arrow (struct state *o, const struct symbol *on)
 	if ((a = ht_lookup (&o->arrows, &fake)) != NULL)
 		return a;
 
-	if ((a = malloc (sizeof (*a))) == NULL)
-		goto no_arrow;
-
-	a->on = on;
+	if ((a = arena_alloc (&o->automata->arena, sizeof (*a))) == NULL)
+		return NULL;
 
-	if (!ht_insert (&o->arrows, a))
-		goto no_insert;
+	a->on    = on;
+	a->index = 0;
 
 	if ((a->to = state_alloc (o->automata)) == NULL)
-		goto no_state;
+		return NULL;
+
+	if (!ht_insert (&o->arrows, a)) {
+		state_free (a->to);
+		return NULL;
+	}
 
 	return a;
-no_state:
-no_insert:
-	free (a);
-no_arrow:
-	return NULL;
+}
+
+struct lookahead *state_add_lookahead (struct state *o,
+				       const struct item *item)
+{
+	struct lookahead fake = { item }, *la;
+
+	if ((la = ht_lookup (&o->lookaheads, &fake)) != NULL)
+		return la;
+
+	if ((la = arena_alloc (&o->automata->arena, sizeof (*la))) == NULL)
+		return NULL;
+
+	la->item = item;
+	bitset_init (&la->set);
+
+	if (!ht_insert (&o->lookaheads, la))
+		return NULL;
+
+	return la;
+}
+
+const struct bitset *state_lookahead (const struct state *o,
+				      const struct item *item)
+{
+	struct lookahead fake = { item }, *la;
+
+	la = ht_lookup (&o->lookaheads, &fake);
+	return la == NULL ? NULL : &la->set;
+}
+
+int state_closure (const struct state *o, struct bitset *set)
+{
+	struct automata *a = o->automata;
+	const size_t base = a->grammar->nterms;
+	size_t i;
+	const struct item *it;
+	const struct symbol *s;
+
+	bitset_clear (set);
+
+	ht_foreach (i, it, &o->items)
+		if (!bitset_add (set, it->id))
+			return 0;
+
+	ht_foreach (i, it, &o->items)
+		if ((s = it->rule->prod[it->pos]) != NULL && s->rules != NULL) {
+			if (!bitset_join (set, a->closure + s->id - base))
+				return 0;
+
+			++a->closure_joins;
+		}
+
+	return 1;
 }
 
 /*
@@ -164,48 +290,135 @@ no_arrow:
 
 int automata_init (struct automata *o)
 {
-	if (!ht_init (&o->items, &item_type))
-		goto no_items;
+	arena_init (&o->arena);
+	o->spare = NULL;
 
 	if (!ht_init (&o->states, &state_type))
 		goto no_states;
 
-	o->start = NULL;
+	if (!da_init (&o->state, NULL))
+		goto no_state;
+
+	o->states.flags = HT_INCREMENTAL;
+
+	o->flags   = 0;
+	o->grammar = NULL;
+	o->items   = NULL;
+	o->start   = NULL;
+
+	o->closure       = NULL;
+	o->closure_joins = 0;
 	return 1;
+no_state:
+	ht_fini (&o->states);
 no_states:
-	ht_fini (&o->items);
-no_items:
 	return 0;
 }
 
+static void closure_fini (struct automata *o)
+{
+	size_t i;
+
+	if (o->closure == NULL)
+		return;
+
+	for (i = o->grammar->nterms; i < o->grammar->nsymbols; ++i)
+		bitset_fini (o->closure + i - o->grammar->nterms);
+
+	free (o->closure);
+	o->closure = NULL;
+}
+
 void automata_fini (struct automata *o)
 {
-	ht_fini (&o->items);
+	da_fini (&o->state);
 	ht_fini (&o->states);
+	closure_fini (o);
+	free (o->items);
+	arena_fini (&o->arena);
 }
 
-const struct item *automata_add_item (struct automata *o,
-				      const struct rule *rule, size_t pos)
+/*
+ * Closure of non-terminal A is a set of initial items of rules of A
+ * and closures of all B for rules A → B β. Closures are calculated
+ * once over the relation A → B.
+ */
+static int closure_init (struct automata *o)
 {
-	struct item *item, fake = {rule, pos};
+	const struct grammar *g = o->grammar;
+	const size_t base = g->nterms, count = g->nsymbols - g->nterms;
+	struct relation R;
+	size_t i;
+	const struct rule *r;
 
-	if ((item = ht_lookup (&o->items, &fake)) != NULL)
-		return item;
+	if ((o->closure = malloc (sizeof (o->closure[0]) * count)) == NULL)
+		return 0;
 
-	if ((item = malloc (sizeof (*item))) == NULL)
-		goto no_item;
+	for (i = 0; i < count; ++i)
+		bitset_init (o->closure + i);
 
-	item->rule = rule;
-	item->pos  = pos;
+	relation_init (&R);
 
-	if (!ht_insert (&o->items, item))
-		goto no_insert;
+	for (i = 0; i < g->nrules; ++i) {
+		r = g->rule[i];
 
-	return ht_lookup (&o->items, item);
-no_insert:
-	free (item);
-no_item:
-	return NULL;
+		if (!bitset_add (o->closure + r->nt->id - base, r->item))
+			goto error;
+
+		if (r->prod[0] != NULL && r->prod[0]->rules != NULL &&
+		    !relation_add (&R, r->nt->id - base, r->prod[0]->id - base))
+			goto error;
+	}
+
+	if (!digraph (&R, count, o->closure))
+		goto error;
+
+	relation_fini (&R);
+	return 1;
+error:
+	relation_fini (&R);
+	closure_fini (o);
+	return 0;
+}
+
+int automata_prepare (struct automata *o, const struct grammar *g)
+{
+	size_t i, pos;
+	const struct rule *r;
+	struct item *it;
+
+	if (g->rule == NULL) {
+		errno = EINVAL;  /* grammar is not numbered */
+		return 0;
+	}
+
+	if ((it = malloc (sizeof (it[0]) * g->nitems)) == NULL)
+		return 0;
+
+	closure_fini (o);
+	free (o->items);
+	o->grammar = g;
+	o->items   = it;
+
+	for (i = 0; i < g->nrules; ++i)
+		for (r = g->rule[i], pos = 0; ; ++pos) {
+			it = o->items + r->item + pos;
+
+			it->rule = r;
+			it->pos  = pos;
+			it->id   = r->item + pos;
+
+			if (r->prod[pos] == NULL)
+				break;
+		}
+
+	return closure_init (o);
+}
+
+const struct item *automata_add_item (struct automata *o,
+				      const struct rule *rule, size_t pos)
+{
+	return o->items + rule->item + pos;
 }
 
 const struct state *automata_add_state (struct automata *o, struct state *s)
@@ -215,7 +428,7 @@ const struct state *automata_add_state (struct automata *o, struct state *s)
 	if ((state = ht_lookup (&o->states, s)) != NULL)
 		return state;
 
-	if (!ht_insert (&o->states, s))
+	if (!automata_insert_state (o, s))
 		return NULL;
 
 	if (o->start == NULL)
@@ -223,3 +436,17 @@ const struct state *automata_add_state (struct automata *o, struct state *s)
 
 	return s;
 }
+
+int automata_insert_state (struct automata *o, struct state *s)
+{
+	s->index = o->state.count;
+
+	if (!da_insert (&o->state, s))
+		return 0;
+
+	if (ht_insert (&o->states, s))
+		return 1;
+
+	--o->state.count;
+	return 0;
+}
@@ -21,26 +21,74 @@ int bitset_eq (const void *a, const void *b)
 	if (p->count != q->count)
 		return 0;
 
-	return memcmp (p->set, q->set, p->count * sizeof (p->set[0])) == 0;
+	return p->count == 0 ||
+	       memcmp (p->set, q->set, p->count * sizeof (p->set[0])) == 0;
 }
 
 size_t bitset_hash (const void *o)
 {
 	const struct bitset *p = o;
+	size_t state, i;
 
-	return hash (0, p->set, p->count * sizeof (p->set[0]));
+	for (state = 0, i = 0; i < p->count; ++i)
+		if (p->set[i] != 0)
+			state = hash_mix (state ^ i ^ p->set[i]);
+
+	return state;
 }
 
 int bitset_is_member (const struct bitset *o, size_t x)
 {
 	const size_t size = sizeof (o->set[0]) * CHAR_BIT;
-	const size_t pos = (x + (CHAR_BIT - 1)) / size;
-	const size_t bit = (x + (CHAR_BIT - 1)) % size;
+	const size_t pos = x / size;
+	const uintmax_t bit = (uintmax_t) 1 << (x % size);
 
 	if (pos >= o->count)
 		return 0;
 
-	return (o->set[pos] | (1 << bit)) != 0;
+	return (o->set[pos] & bit) != 0;
+}
+
+/* returns non-zero if a ∩ b is not empty */
+int bitset_meet (const struct bitset *a, const struct bitset *b)
+{
+	const size_t min = a->count < b->count ? a->count : b->count;
+	size_t i;
+
+	for (i = 0; i < min; ++i)
+		if ((a->set[i] & b->set[i]) != 0)
+			return 1;
+
+	return 0;
+}
+
+/* returns number of members */
+size_t bitset_count (const struct bitset *o)
+{
+	size_t count, i;
+
+	for (count = 0, i = 0; i < o->count; ++i)
+		count += __builtin_popcountll (o->set[i]);
+
+	return count;
+}
+
+/* returns first member not less than x or SIZE_MAX if none */
+size_t bitset_next (const struct bitset *o, size_t x)
+{
+	const size_t size = sizeof (o->set[0]) * CHAR_BIT;
+	size_t pos = x / size;
+	uintmax_t word;
+
+	if (pos >= o->count)
+		return SIZE_MAX;
+
+	for (word = o->set[pos] >> (x % size) << (x % size); word == 0;
+	     word = o->set[pos])
+		if (++pos >= o->count)
+			return SIZE_MAX;
+
+	return pos * size + __builtin_ctzll (word);
 }
 
 static int bitset_prepare (struct bitset *o, size_t count)
@@ -50,10 +98,10 @@ static int bitset_prepare (struct bitset *o, size_t count)
 	if (count <= o->count)
 		return 1;
 
-	if ((p = realloc (o->set, count)) == NULL)
+	if ((p = realloc (o->set, count * sizeof (p[0]))) == NULL)
 		return 0;
 
-	memset (p + o->count, 0, (count - o->count) * sizeof (o->set[0]));
+	memset (p + o->count, 0, (count - o->count) * sizeof (p[0]));
 
 	o->count = count;
 	o->set = p;
@@ -69,13 +117,13 @@ static void bitset_shrink (struct bitset *o)
 int bitset_add (struct bitset *o, size_t x)
 {
 	const size_t size = sizeof (o->set[0]) * CHAR_BIT;
-	const size_t pos = (x + (CHAR_BIT - 1)) / size;
-	const size_t bit = (x + (CHAR_BIT - 1)) % size;
+	const size_t pos = x / size;
+	const uintmax_t bit = (uintmax_t) 1 << (x % size);
 
 	if (!bitset_prepare (o, pos + 1))
 		return 0;
 
-	o->set[pos] |= (1 << bit);
+	o->set[pos] |= bit;
 	return 1;
 }
 
@@ -83,11 +131,11 @@ int bitset_add (struct bitset *o, size_t x)
 void bitset_del (struct bitset *o, size_t x)
 {
 	const size_t size = sizeof (o->set[0]) * CHAR_BIT;
-	const size_t pos = (x + (CHAR_BIT - 1)) / size;
-	const size_t bit = (x + (CHAR_BIT - 1)) % size;
+	const size_t pos = x / size;
+	const uintmax_t bit = (uintmax_t) 1 << (x % size);
 
 	if (pos < o->count)
-		o->set[pos] &= ~(1 << bit);
+		o->set[pos] &= ~bit;
 
 	bitset_shrink (o);
 }
@@ -98,7 +146,7 @@ int bitset_join (struct bitset *o, const struct bitset *s)
 	size_t i;
 
 	if (o->count < s->count && !bitset_prepare (o, s->count))
-			return 0;
+		return 0;
 
 	for (i = 0; i < s->count; ++i)
 		o->set[i] |= s->set[i];
@@ -26,31 +26,38 @@ void da_fini (struct da *da)
 {
 	size_t i;
 
-	if (da->type == NULL || da->type->free == NULL)
-		return;
+	if (da->type != NULL && da->type->free != NULL)
+		for (i = 0; i < da->count; ++i)
+			da->type->free (da->table[i]);
 
-	for (i = 0; i < da->count; ++i)
-		da->type->free (da->table[i]);
+	free (da->table);
 }
 
-static int resize (struct da *da)
+int da_reserve (struct da *da, size_t count)
 {
-	if (da->count < da->size)
-		return 1;
-
-	const size_t size = da->size * 2;
 	void **table;
 
-	if ((table = realloc (da->table, sizeof (table[0]) * size)) == NULL)
+	if (count <= da->size)
+		return 1;
+
+	if ((table = realloc (da->table, sizeof (table[0]) * count)) == NULL)
 		return 0;
 
-	memset (table + da->size, 0, sizeof (table[0]) * da->size);
+	memset (table + da->size, 0, sizeof (table[0]) * (count - da->size));
 
-	da->size  = size;
+	da->size  = count;
 	da->table = table;
 	return 1;
 }
 
+static int resize (struct da *da)
+{
+	if (da->count < da->size)
+		return 1;
+
+	return da_reserve (da, da->size * 2);
+}
+
 int da_insert (struct da *da, void *o)
 {
 	if (!resize (da))
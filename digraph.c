@@ -0,0 +1,135 @@
+/*
+ * Relation Closure on Directed Graph
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <data/digraph.h>
+
+int relation_add (struct relation *o, size_t from, size_t to)
+{
+	size_t (*pair)[2];
+	size_t size;
+
+	if (o->count >= o->size) {
+		size = o->size == 0 ? 16 : o->size * 2;
+
+		if ((pair = realloc (o->pair, sizeof (pair[0]) * size)) == NULL)
+			return 0;
+
+		o->size = size;
+		o->pair = pair;
+	}
+
+	o->pair[o->count][0] = from;
+	o->pair[o->count][1] = to;
+	++o->count;
+	return 1;
+}
+
+static int bitset_copy (struct bitset *o, const struct bitset *s)
+{
+	bitset_clear (o);
+	return bitset_join (o, s);
+}
+
+int digraph (const struct relation *R, size_t count, struct bitset *F)
+{
+	size_t *mem, *start, *to, *N, *stack, *path, *edge, *mark;
+	size_t i, x, y, top, depth;
+
+	mem = malloc (sizeof (mem[0]) * (count * 6 + 1 + R->count));
+	if (mem == NULL)
+		return 0;
+
+	start = mem;
+	to    = start + count + 1;
+	N     = to + R->count;
+	stack = N + count;
+	path  = stack + count;
+	edge  = path + count;
+	mark  = edge + count;
+
+	/* convert relation to adjacency arrays: R(x) = to[start[x] ...] */
+
+	memset (start, 0, sizeof (start[0]) * (count + 1));
+	memset (N, 0, sizeof (N[0]) * count);
+
+	for (i = 0; i < R->count; ++i)
+		++start[R->pair[i][0]];
+
+	for (i = 1; i <= count; ++i)
+		start[i] += start[i - 1];
+
+	for (i = 0; i < R->count; ++i)
+		to[--start[R->pair[i][0]]] = R->pair[i][1];
+
+	/* traverse with explicit path stack */
+
+	for (i = 0, top = 0, depth = 0; i < count; ++i) {
+		if (N[i] != 0)
+			continue;
+
+		stack[top++] = i;
+		N[i] = mark[depth] = top;
+		edge[depth] = start[i];
+		path[depth++] = i;
+
+		while (depth > 0) {
+			x = path[depth - 1];
+
+			if (edge[depth - 1] < start[x + 1]) {
+				y = to[edge[depth - 1]++];
+
+				if (N[y] == 0) {
+					stack[top++] = y;
+					N[y] = mark[depth] = top;
+					edge[depth] = start[y];
+					path[depth++] = y;
+					continue;
+				}
+
+				if (N[y] < N[x])
+					N[x] = N[y];
+
+				if (!bitset_join (F + x, F + y))
+					goto error;
+
+				continue;
+			}
+
+			if (N[x] == mark[--depth])
+				do {
+					y = stack[--top];
+					N[y] = SIZE_MAX;
+
+					if (y != x && !bitset_copy (F + y, F + x))
+						goto error;
+				}
+				while (y != x);
+
+			if (depth == 0)
+				break;
+
+			y = path[depth - 1];
+
+			if (N[x] < N[y])
+				N[y] = N[x];
+
+			if (!bitset_join (F + y, F + x))
+				goto error;
+		}
+	}
+
+	free (mem);
+	return 1;
+error:
+	free (mem);
+	return 0;
+}
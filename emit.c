@@ -0,0 +1,45 @@
+/*
+ * Buffered Text Emitter
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <data/emit.h>
+
+void emit_init (struct emit *o, FILE *f)
+{
+	o->f     = f;
+	o->next  = o->buf;
+	o->error = 0;
+}
+
+int emit_fini (struct emit *o)
+{
+	emit_flush (o);
+	return !o->error;
+}
+
+void emit_flush (struct emit *o)
+{
+	const size_t len = o->next - o->buf;
+
+	if (len > 0)
+		o->error |= fwrite (o->buf, 1, len, o->f) != len;
+
+	o->next = o->buf;
+}
+
+void emit_size (struct emit *o, size_t x)
+{
+	char buf[24], *p = buf + sizeof (buf);
+
+	do {
+		*--p = '0' + x % 10;
+		x /= 10;
+	}
+	while (x != 0);
+
+	emit_mem (o, p, buf + sizeof (buf) - p);
+}
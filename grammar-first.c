@@ -0,0 +1,202 @@
+/*
+ * Context-Free Grammar Analysis
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include <data/digraph.h>
+#include <parser/grammar-first.h>
+
+int grammar_seq_is_nullable (const struct symbol *const *seq,
+			     const struct bitset *nullable)
+{
+	size_t i;
+
+	for (i = 0; seq[i] != NULL; ++i)
+		if (!bitset_is_member (nullable, seq[i]->id))
+			return 0;
+
+	return 1;
+}
+
+static int nullable_add (struct bitset *set, const struct symbol *s,
+			 size_t *queue, size_t *tail)
+{
+	if (bitset_is_member (set, s->id))
+		return 1;
+
+	queue[(*tail)++] = s->id;
+	return bitset_add (set, s->id);
+}
+
+/*
+ * Every rule counts symbols of its production not yet known to be
+ * nullable. When a symbol becomes nullable the counters of rules with
+ * its occurrences are decremented, and rule with zero counter makes its
+ * non-terminal nullable. Every occurrence is visited once.
+ */
+int grammar_nullable (const struct grammar *o, struct bitset *set)
+{
+	const size_t occurs = o->nitems - o->nrules;
+	size_t *mem, *count, *start, *occur, *queue, head, tail, i, j, x;
+	const struct rule *r;
+	int ok = 0;
+
+	bitset_clear (set);
+
+	mem = malloc (sizeof (mem[0]) *
+		      (o->nrules + o->nsymbols + 1 + occurs + o->nsymbols));
+	if (mem == NULL)
+		return 0;
+
+	count = mem;
+	start = count + o->nrules;
+	occur = start + o->nsymbols + 1;
+	queue = occur + occurs;
+
+	for (i = 0; i <= o->nsymbols; ++i)
+		start[i] = 0;
+
+	for (i = 0; i < o->nrules; ++i)
+		for (r = o->rule[i], j = 0; r->prod[j] != NULL; ++j)
+			++start[r->prod[j]->id + 1];
+
+	for (i = 0; i < o->nsymbols; ++i)
+		start[i + 1] += start[i];
+
+	for (head = tail = 0, i = 0; i < o->nrules; ++i) {
+		for (r = o->rule[i], j = 0; r->prod[j] != NULL; ++j)
+			occur[start[r->prod[j]->id]++] = i;
+
+		if ((count[i] = j) == 0 &&
+		    !nullable_add (set, r->nt, queue, &tail))
+			goto error;
+	}
+
+	/* start[x] now points to the end of occurrences of x */
+	for (i = o->nsymbols; i > 0; --i)
+		start[i] = start[i - 1];
+
+	start[0] = 0;
+
+	while (head < tail)
+		for (x = queue[head++], i = start[x]; i < start[x + 1]; ++i)
+			if (--count[occur[i]] == 0 &&
+			    !nullable_add (set, o->rule[occur[i]]->nt, queue,
+					   &tail))
+				goto error;
+
+	ok = 1;
+error:
+	free (mem);
+	return ok;
+}
+
+int grammar_seq_first (const struct symbol *const *seq,
+		       const struct bitset *nullable,
+		       const struct bitset *first, struct bitset *set)
+{
+	size_t i;
+
+	for (i = 0; seq[i] != NULL; ++i) {
+		if (!bitset_join (set, first + seq[i]->id))
+			return 0;
+
+		if (!bitset_is_member (nullable, seq[i]->id))
+			break;
+	}
+
+	return 1;
+}
+
+/*
+ * FIRST (A) includes FIRST (X) for every rule A → α X β with nullable
+ * α, the closure of this relation is calculated by digraph.
+ */
+int grammar_first (const struct grammar *o, const struct bitset *nullable,
+		   struct bitset *first)
+{
+	struct relation R;
+	size_t i, j;
+	const struct rule *r;
+
+	for (i = 0; i < o->nsymbols; ++i)
+		bitset_clear (first + i);
+
+	for (i = 0; i < o->nterms; ++i)
+		if (!bitset_add (first + i, i))
+			return 0;
+
+	relation_init (&R);
+
+	for (i = 0; i < o->nrules; ++i)
+		for (r = o->rule[i], j = 0; r->prod[j] != NULL; ++j) {
+			if (!relation_add (&R, r->nt->id, r->prod[j]->id))
+				goto error;
+
+			if (!bitset_is_member (nullable, r->prod[j]->id))
+				break;
+		}
+
+	if (!digraph (&R, o->nsymbols, first))
+		goto error;
+
+	relation_fini (&R);
+	return 1;
+error:
+	relation_fini (&R);
+	return 0;
+}
+
+/*
+ * For every rule A → α B β FOLLOW (B) includes FIRST (β) and, if β is
+ * nullable, FOLLOW (A). The latter relation is closed by digraph.
+ */
+int grammar_follow (const struct grammar *o, const struct bitset *nullable,
+		    const struct bitset *first, struct bitset *follow)
+{
+	struct relation R;
+	size_t i, j;
+	const struct rule *r;
+	const struct symbol *B;
+	int tail;
+
+	for (i = 0; i < o->nsymbols; ++i)
+		bitset_clear (follow + i);
+
+	if (o->start != NULL && !bitset_add (follow + o->start->id, o->nterms))
+		return 0;
+
+	relation_init (&R);
+
+	for (i = 0; i < o->nrules; ++i) {
+		r = o->rule[i];
+
+		for (j = 0; r->prod[j] != NULL; ++j) {}
+
+		for (tail = 1; j-- > 0; ) {
+			B = r->prod[j];
+
+			if (B->rules != NULL &&
+			    (!grammar_seq_first (r->prod + j + 1, nullable,
+						 first, follow + B->id) ||
+			     (tail && !relation_add (&R, B->id, r->nt->id))))
+				goto error;
+
+			tail = tail && bitset_is_member (nullable, B->id);
+		}
+	}
+
+	if (!digraph (&R, o->nsymbols, follow))
+		goto error;
+
+	relation_fini (&R);
+	return 1;
+error:
+	relation_fini (&R);
+	return 0;
+}
@@ -36,6 +36,13 @@ void grammar_show (const struct grammar *o, FILE *f)
 
 	fprintf (f, "start symbol: %s\n", o->start->name);
 
+	if (o->rule != NULL) {  /* numbered: show in stable order */
+		for (i = 0; i < o->nrules; ++i)
+			rule_show (o->rule[i], f);
+
+		return;
+	}
+
 	ht_foreach (i, s, &o->symbols)
 		if (s->rules != NULL)
 			symbol_show (s, f);
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <data/arena.h>
 #include <data/atom.h>
 #include <data/atom-seq.h>
 #include <data/string.h>
@@ -17,11 +18,10 @@
 #include <parser/grammar.h>
 
 /*
- * Grammar Name
+ * Grammar Name: names are owned by grammar arena
  */
 
 static const struct data_type name_type = {
-	.free	= free,
 	.eq	= string_eq,
 	.hash	= string_hash,
 };
@@ -31,14 +31,15 @@ static const struct data_type name_type = {
  *
  * 1. Names are not owned by symbol.
  * 2. Distinct name pointers point to distinct names.
- * 3. Rules are owned by symbol.
+ * 3. Rules are owned by symbol, symbols and rules are allocated in
+ *    grammar arena.
  */
 
-static struct symbol *symbol_alloc (const char *name)
+static struct symbol *symbol_alloc (struct grammar *g, const char *name)
 {
 	struct symbol *s;
 
-	if ((s = malloc (sizeof (*s))) == NULL)
+	if ((s = arena_alloc (&g->arena, sizeof (*s))) == NULL)
 		return NULL;
 
 	s->name  = name;
@@ -53,12 +54,8 @@ static void symbol_free (void *o)
 	if (s == NULL)
 		return;
 
-	if (s->rules != NULL) {
+	if (s->rules != NULL)
 		ht_fini (s->rules);
-		free (s->rules);
-	}
-
-	free (s);
 }
 
 static int symbol_eq (const void *a, const void *b)
@@ -107,7 +104,6 @@ static size_t rule_hash (const void *o)
 }
 
 static const struct data_type rule_type = {
-	.free	= free,
 	.eq	= rule_eq,
 	.hash	= rule_hash,
 };
@@ -118,13 +114,24 @@ static const struct data_type rule_type = {
 
 int grammar_init (struct grammar *o)
 {
+	arena_init (&o->arena);
+
 	if (!ht_init (&o->names, &name_type))
 		goto no_names;
 
 	if (!ht_init (&o->symbols, &symbol_type))
 		goto no_symbols;
 
+	o->names.flags   = HT_INCREMENTAL;
+	o->symbols.flags = HT_INCREMENTAL;
 	o->start = NULL;
+
+	o->nterms   = 0;
+	o->nsymbols = 0;
+	o->nrules   = 0;
+	o->nitems   = 0;
+	o->symbol   = NULL;
+	o->rule     = NULL;
 	return 1;
 no_symbols:
 	ht_fini (&o->names);
@@ -134,8 +141,22 @@ no_names:
 
 void grammar_fini (struct grammar *o)
 {
+	free (o->symbol);
+	free (o->rule);
+
 	ht_fini (&o->symbols);
 	ht_fini (&o->names);
+	arena_fini (&o->arena);
+}
+
+void *grammar_alloc (struct grammar *o, size_t size)
+{
+	return arena_alloc (&o->arena, size);
+}
+
+int grammar_reserve (struct grammar *o, size_t count)
+{
+	return ht_reserve (&o->names, count) && ht_reserve (&o->symbols, count);
 }
 
 const char *grammar_add_name (struct grammar *o, const char *name)
@@ -146,33 +167,39 @@ const char *grammar_add_name (struct grammar *o, const char *name)
 	if ((n = ht_lookup (&o->names, name)) != NULL)
 		return n;
 
-	if ((copy = strdup (name)) == NULL)
-		goto no_copy;
-
-	if (!ht_insert (&o->names, copy))
-		goto no_insert;
+	if ((copy = arena_strdup (&o->arena, name)) == NULL ||
+	    !ht_insert (&o->names, copy))
+		return NULL;
 
 	return copy;
-no_insert:
-	free (copy);
-no_copy:
-	return NULL;
+}
+
+struct symbol *grammar_lookup_symbol (const struct grammar *o,
+				      const char *name)
+{
+	struct symbol fake;
+
+	if ((fake.name = ht_lookup (&o->names, name)) == NULL)
+		return NULL;
+
+	return ht_lookup (&o->symbols, &fake);
 }
 
 struct symbol *grammar_add_symbol (struct grammar *o, const char *name)
 {
-	struct symbol *s, fake;
+	struct symbol *s;
 
-	if ((fake.name = ht_lookup (&o->names, name)) != NULL &&
-	    (s = ht_lookup (&o->symbols, &fake)) != NULL)
+	if ((s = grammar_lookup_symbol (o, name)) != NULL)
 		return s;
 
 	if ((name = grammar_add_name (o, name)) == NULL)
 		goto no_name;
 
-	if ((s = symbol_alloc (name)) == NULL)
+	if ((s = symbol_alloc (o, name)) == NULL)
 		goto no_symbol;
 
+	s->id = o->symbols.count;  /* order of appearance */
+
 	if (!ht_insert (&o->symbols, s))
 		goto no_insert;
 
@@ -187,35 +214,127 @@ no_name:
 	return NULL;
 }
 
-static int symbol_init_rules (struct symbol *o)
+static int symbol_init_rules (struct grammar *g, struct symbol *o)
 {
+	struct ht *rules;
+
 	if (o->rules != NULL)
 		return 1;
 
-	if ((o->rules = malloc (sizeof (*o->rules))) == NULL)
-		goto no_rules;
-
-	if (!ht_init (o->rules, &rule_type))
-		goto no_ht;
+	if ((rules = arena_alloc (&g->arena, sizeof (*rules))) == NULL ||
+	    !ht_init (rules, &rule_type))
+		return 0;
 
+	o->rules = rules;
 	return 1;
-no_ht:
-	free (o->rules);
-	o->rules = NULL;
-no_rules:
-	return 0;
-
 }
 
-int symbol_insert_rule (struct symbol *o, struct rule *rule)
+int symbol_insert_rule (struct grammar *g, struct symbol *o,
+			struct rule *rule)
 {
 	if (o->name != rule->nt->name) {
 		errno = EINVAL;
 		return 0;
 	}
 
-	if (!symbol_init_rules (o))
+	if (!symbol_init_rules (g, o))
 		return 0;
 
+	rule->id = o->rules->count;  /* order of insertion */
 	return ht_insert (o->rules, rule);
 }
+
+/*
+ * Grammar Numbering
+ */
+
+static size_t rule_len (const struct rule *r)
+{
+	size_t i;
+
+	for (i = 0; r->prod[i] != NULL; ++i) {}
+
+	return i;
+}
+
+static size_t count_rules (const struct grammar *o)
+{
+	struct symbol *s;
+	size_t i, count = 0;
+
+	ht_foreach (i, s, &o->symbols)
+		if (s->rules != NULL)
+			count += s->rules->count;
+
+	return count;
+}
+
+int grammar_number (struct grammar *o)
+{
+	struct symbol **order, *s;
+	struct rule *r;
+	size_t i, j, id, base;
+
+	if (o->symbol != NULL) {
+		if (o->symbols.count == o->nsymbols &&
+		    count_rules (o) == o->nrules)
+			return 1;
+
+		errno = EBUSY;  /* identifiers are given out already */
+		return 0;
+	}
+
+	o->nsymbols = o->symbols.count;
+
+	if ((order = malloc (sizeof (order[0]) * o->nsymbols)) == NULL)
+		goto no_order;
+
+	if ((o->symbol = malloc (sizeof (o->symbol[0]) * o->nsymbols)) == NULL)
+		goto no_symbol;
+
+	o->nterms = 0;
+	o->nrules = 0;
+
+	ht_foreach (i, s, &o->symbols) {
+		order[s->id] = s;
+
+		if (s->rules == NULL)
+			++o->nterms;
+		else
+			o->nrules += s->rules->count;
+	}
+
+	if ((o->rule = malloc (sizeof (o->rule[0]) * o->nrules)) == NULL)
+		goto no_rule;
+
+	for (i = 0, id = 0; i < o->nsymbols; ++i)
+		if (order[i]->rules == NULL)
+			o->symbol[order[i]->id = id++] = order[i];
+
+	for (i = 0, base = 0; i < o->nsymbols; ++i) {
+		if ((s = order[i])->rules == NULL)
+			continue;
+
+		o->symbol[s->id = id++] = s;
+
+		ht_foreach (j, r, s->rules)
+			o->rule[r->id = base + r->id] = r;
+
+		base += s->rules->count;
+	}
+
+	for (i = 0, o->nitems = 0; i < o->nrules; ++i) {
+		o->rule[i]->item = o->nitems;
+		o->nitems += rule_len (o->rule[i]) + 1;
+	}
+
+	free (order);
+	return 1;
+no_rule:
+	free (o->symbol);
+	o->symbol = NULL;
+no_symbol:
+	free (order);
+no_order:
+	return 0;
+}
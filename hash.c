@@ -6,23 +6,102 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <string.h>
 #include <data/hash.h>
 
-/* Jenkins One-at-a-time hash */
-size_t hash (size_t hash, const void *data, size_t size)
+size_t hash_seed;
+
+static uint64_t load (const unsigned char *p)
+{
+	uint64_t x;
+
+	memcpy (&x, p, sizeof (x));
+	return x;
+}
+
+/* loads count < 8 bytes as the low bytes of a word */
+static uint64_t load_tail (const unsigned char *p, size_t count)
 {
-	const unsigned char *p;
+	uint64_t x;
 	size_t i;
 
-	for (p = data, i = 0; i < size; ++i) {
-		hash += p[i];
-		hash += (hash << 10);
-		hash ^= (hash >> 6);
+	for (x = 0, i = count; i > 0; --i)
+		x = (x << 8) | p[i - 1];
+
+	return x;
+}
+
+static size_t finish (size_t state, uint64_t tail, size_t size)
+{
+	if (size % 8 != 0)
+		state = hash_step (state, tail);
+
+	return hash_mix (state ^ size);
+}
+
+size_t hash (size_t seed, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	size_t state, i;
+
+	for (state = seed, i = 0; i + 8 <= size; i += 8)
+		state = hash_step (state, load (p + i));
+
+	return finish (state, load_tail (p + i, size - i), size);
+}
+
+#if defined (__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+#define ONES   0x0101010101010101ULL
+#define HIGHS  0x8080808080808080ULL
+#define PAGE   4096
+
+/*
+ * Words are read up to the terminating zero byte and may read past it,
+ * but never cross a page boundary after it, like the strlen of libc.
+ * Zero detection of (x - ONES) & ~x & HIGHS is exact for the first zero
+ * byte of a little-endian word.
+ */
+__attribute__ ((no_sanitize_address))
+size_t hash_string (size_t seed, const char *s)
+{
+	const unsigned char *p = (const void *) s;
+	size_t state = seed, i = 0, n;
+	uint64_t x, zero;
+
+	for (;;) {
+		if (((uintptr_t) (p + i) & (PAGE - 1)) > PAGE - 8) {
+			for (n = 0; n < 8 && p[i + n] != 0; ++n) {}
+
+			if (n < 8)
+				return finish (state, load_tail (p + i, n),
+					       i + n);
+
+			state = hash_step (state, load (p + i));
+			i += 8;
+			continue;
+		}
+
+		memcpy (&x, p + i, sizeof (x));
+
+		if ((zero = (x - ONES) & ~x & HIGHS) != 0)
+			break;
+
+		state = hash_step (state, x);
+		i += 8;
 	}
 
-	hash += (hash << 3);
-	hash ^= (hash >> 11);
-	hash += (hash << 15);
+	n = __builtin_ctzll (zero) / 8;  /* index of zero byte */
+	x &= ((uint64_t) 1 << (n * 8)) - 1;
+
+	return finish (state, x, i + n);
+}
+
+#else
 
-	return hash;
+size_t hash_string (size_t seed, const char *s)
+{
+	return hash (seed, s, strlen (s));
 }
+
+#endif
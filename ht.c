@@ -8,26 +8,180 @@
 
 #include <errno.h>
 #include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <data/ht.h>
 
+/*
+ * Slots, hashes and control bytes are allocated in one block in that
+ * order.
+ */
+static void **table_alloc (size_t size, size_t **hash, unsigned char **ctrl)
+{
+	void **table;
+
+	table = calloc (1, (sizeof (table[0]) + sizeof (hash[0][0])) * size +
+			   size + HT_GROUP);
+	if (table == NULL)
+		return NULL;
+
+	*hash = (void *) (table + size);
+	*ctrl = (void *) (*hash + size);  /* zeroed: HT_EMPTY */
+	return table;
+}
+
 int ht_init (struct ht *ht, const struct data_type *type)
 {
 	ht->type  = type;
+	ht->flags = 0;
 	ht->count = 0;
 	ht->size  = 4;
 
-	return (ht->table = calloc (ht->size, sizeof (ht->table[0]))) != NULL;
+	ht->old_size  = 0;
+	ht->moved     = 0;
+	ht->old_table = NULL;
+
+	ht->table = table_alloc (ht->size, &ht->hash, &ht->ctrl);
+	return ht->table != NULL;
 }
 
 void ht_fini (struct ht *ht)
 {
 	size_t i;
+	void *o;
 
-	if (ht->type->free == NULL)
-		return;
+	if (ht->type->free != NULL)
+		ht_foreach (i, o, ht)
+			ht->type->free (o);
+
+	free (ht->table);
+	free (ht->old_table);
+}
+
+/*
+ * Tag is taken from the high bits of scrambled hash, low bits are used
+ * for slot. The high bit marks used slot.
+ */
+static unsigned char get_tag (size_t hash)
+{
+	return 0x80 | (unsigned long long) hash * 0x9e3779b97f4a7c15ULL >> 57;
+}
+
+static void set_ctrl (unsigned char *ctrl, size_t size, size_t i,
+		      unsigned char c)
+{
+	for (ctrl[i] = c, i += size; i < size + HT_GROUP; i += size)
+		ctrl[i] = c;  /* clone */
+}
+
+#ifdef __SSE2__
+/*
+ * Returns bit mask of group slots with tag matches before the first
+ * empty slot, and stores bit mask of empty slots
+ */
+static unsigned group_match (const unsigned char *ctrl, unsigned char tag,
+			     unsigned *empty)
+{
+	const __m128i g = _mm_loadu_si128 ((const void *) ctrl);
+	const unsigned match =
+		_mm_movemask_epi8 (_mm_cmpeq_epi8 (g, _mm_set1_epi8 (tag)));
+
+	*empty = ~_mm_movemask_epi8 (g) & 0xffff;  /* no high bit */
+	return *empty == 0 ? match : match & ((*empty & -*empty) - 1);
+}
+#else
+static unsigned group_match (const unsigned char *ctrl, unsigned char tag,
+			     unsigned *empty)
+{
+	unsigned match = 0, i;
+
+	for (i = 0; i < HT_GROUP && ctrl[i] != HT_EMPTY; ++i)
+		if (ctrl[i] == tag)
+			match |= 1u << i;
+
+	*empty = i < HT_GROUP ? 1u << i : 0;
+	return match;
+}
+#endif
 
-	for (i = 0; i < ht->size; ++i)
-		ht->type->free (ht->table[i]);
+static unsigned first_bit (unsigned x)
+{
+	return __builtin_ctz (x);
+}
+
+/*
+ * Returns non-zero and stores slot of the item equal to o, or returns
+ * zero and stores the first free slot of its probe sequence. Slots are
+ * probed linearly group by group. Moved slots of the old table keep
+ * their control bytes to not break probe sequences.
+ */
+static int probe (const struct data_type *type, size_t size, void **table,
+		  const size_t *hashes, const unsigned char *ctrl,
+		  const void *o, size_t hash, size_t *slot)
+{
+	const size_t mask = size - 1;  /* size MUST be power of two */
+	const unsigned char tag = get_tag (hash);
+	size_t pos, i;
+	unsigned match, empty;
+
+	for (pos = hash & mask;; pos = (pos + HT_GROUP) & mask) {
+		for (
+			match = group_match (ctrl + pos, tag, &empty);
+			match != 0;
+			match &= match - 1
+		) {
+			i = (pos + first_bit (match)) & mask;
+
+			if (hashes[i] == hash && table[i] != NULL &&
+			    type->eq (table[i], o)) {
+				*slot = i;
+				return 1;
+			}
+		}
+
+		if (empty != 0) {
+			*slot = (pos + first_bit (empty)) & mask;
+			return 0;
+		}
+	}
+}
+
+/*
+ * Returns index of the item equal to o, or the first free slot of the
+ * table for it
+ */
+static size_t get_slot (const struct ht *ht, const void *o, size_t hash)
+{
+	size_t i, j;
+
+	if (probe (ht->type, ht->size, ht->table, ht->hash, ht->ctrl, o, hash,
+		   &i))
+		return i;
+
+	if (ht->old_size != 0 &&
+	    probe (ht->type, ht->old_size, ht->old_table, ht->old_hash,
+		   ht->old_ctrl, o, hash, &j))
+		return ht->size + j;
+
+	return i;
+}
+
+static size_t get_hash (const struct ht *ht, size_t i)
+{
+	return i < ht->size ? ht->hash[i] : ht->old_hash[i - ht->size];
+}
+
+size_t ht_index (const struct ht *ht, const void *o)
+{
+	return get_slot (ht, o, ht->type->hash (o));
+}
+
+void *ht_lookup (const struct ht *ht, const void *o)
+{
+	return ht_at (ht, ht_index (ht, o));
 }
 
 size_t ht_hash (const void *o)
@@ -39,7 +193,7 @@ size_t ht_hash (const void *o)
 	/* NOTE: we need to calculate order-independed hash from items */
 
 	ht_foreach (i, item, p)
-		state += p->type->hash (item);
+		state += get_hash (p, i);
 
 	return state;
 }
@@ -49,81 +203,189 @@ int ht_eq (const void *a, const void *b)
 	const struct ht *p = a;
 	const struct ht *q = b;
 	size_t i;
-	void *item;
+	void *item, *other;
 
 	if (p->count != q->count || p->type != q->type)
 		return 0;
 
 	ht_foreach (i, item, p)
-		if (!p->type->eq (item, ht_lookup (q, item)))
+		if ((other = ht_at (q, get_slot (q, item, get_hash (p, i)))) ==
+		    NULL || !p->type->eq (item, other))
 			return 0;
 
 	return 1;
 }
 
-static size_t get_slot (const struct data_type *type, size_t size,
-			void **table, const void *o)
+/* returns the first free slot for item with the hash */
+static size_t get_free (size_t size, const unsigned char *ctrl, size_t hash)
 {
-	const size_t mask = size - 1;  /* size MUST be power of two */
+	const size_t mask = size - 1;
 	size_t i;
 
-	for (
-		i = type->hash (o) & mask;
-		table[i] != NULL && !type->eq (table[i], o);
-		i = (i + 1) & mask
-	) {}
+	for (i = hash & mask; ctrl[i] != HT_EMPTY; i = (i + 1) & mask) {}
 
 	return i;
 }
 
-size_t ht_index (const struct ht *ht, const void *o)
+static void put (struct ht *ht, size_t i, void *o, size_t hash)
 {
-	return get_slot (ht->type, ht->size, ht->table, o);
+	ht->table[i] = o;
+	ht->hash[i]  = hash;
+	set_ctrl (ht->ctrl, ht->size, i, get_tag (hash));
 }
 
-void *ht_lookup (const struct ht *ht, const void *o)
+/* moves up to count slots of the old table to the new one */
+static void move (struct ht *ht, size_t count)
 {
-	return ht->table[ht_index (ht, o)];
+	size_t hash;
+	void *o;
+
+	for (; count > 0 && ht->moved < ht->old_size; --count, ++ht->moved)
+		if ((o = ht->old_table[ht->moved]) != NULL) {
+			hash = ht->old_hash[ht->moved];
+			put (ht, get_free (ht->size, ht->ctrl, hash), o, hash);
+			ht->old_table[ht->moved] = NULL;
+		}
+
+	if (ht->moved < ht->old_size)
+		return;
+
+	free (ht->old_table);
+
+	ht->old_size  = 0;
+	ht->moved     = 0;
+	ht->old_table = NULL;
+}
+
+/* moves the rest of the old table and makes the current table old */
+static int grow (struct ht *ht, size_t size)
+{
+	void **table;
+	size_t *hash;
+	unsigned char *ctrl;
+
+	move (ht, ht->old_size);
+
+	if ((table = table_alloc (size, &hash, &ctrl)) == NULL)
+		return 0;
+
+	ht->old_size  = ht->size;
+	ht->old_table = ht->table;
+	ht->old_hash  = ht->hash;
+	ht->old_ctrl  = ht->ctrl;
+
+	ht->size  = size;
+	ht->table = table;
+	ht->hash  = hash;
+	ht->ctrl  = ctrl;
+	return 1;
 }
 
 static int resize (struct ht *ht)
 {
+	if (ht->old_size != 0)
+		move (ht, HT_STEP);
+
 	if (ht->count <= ht->size / 2)  /* load factor <= 50% */
 		return 1;
 
-	const size_t size = ht->size * 2;
-	void **table;
-	size_t i;
-	void *o;
-
-	if ((table = calloc (size, sizeof (table[0]))) == NULL)
+	if (!grow (ht, ht->size * 2))
 		return 0;
 
-	ht_foreach (i, o, ht)
-		table[get_slot (ht->type, size, table, o)] = o;
+	move (ht, (ht->flags & HT_INCREMENTAL) != 0 ? HT_STEP : ht->old_size);
+	return 1;
+}
 
-	free (ht->table);
+int ht_reserve (struct ht *ht, size_t count)
+{
+	size_t size;
 
-	ht->size  = size;
-	ht->table = table;
+	for (size = ht->size; size / 2 + 1 < count; size *= 2) {}
+
+	if (size == ht->size) {
+		move (ht, ht->old_size);
+		return 1;
+	}
+
+	if (!grow (ht, size))
+		return 0;
+
+	move (ht, ht->old_size);
 	return 1;
 }
 
 int ht_insert (struct ht *ht, void *o)
 {
-	size_t i;
+	size_t hash, i;
 
 	if (!resize (ht))
 		return 0;
 
-	i = ht_index (ht, o);
+	hash = ht->type->hash (o);
+	i = get_slot (ht, o, hash);  /* free slot is in the new table */
 
-	if (ht->table[i] != NULL) {
+	if (ht_at (ht, i) != NULL) {
 		errno = EEXIST;
 		return 0;
 	}
 
 	++ht->count;
-	ht->table[i] = o;
+	put (ht, i, o, hash);
 	return 1;
 }
+
+int ht_insert_many (struct ht *ht, void **o, size_t count)
+{
+	size_t i;
+
+	if (!ht_reserve (ht, ht->count + count))
+		return 0;
+
+	for (i = 0; i < count; ++i)
+		if (!ht_insert (ht, o[i]))
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Backward-shift deletion: items of the probe run after the free slot
+ * whose home slot is not between the free slot and them move back into
+ * it, thus runs stay contiguous without tombstones
+ */
+static void shift (struct ht *ht, size_t i)
+{
+	const size_t mask = ht->size - 1;
+	size_t j, home;
+
+	for (j = (i + 1) & mask; ht->ctrl[j] != HT_EMPTY; j = (j + 1) & mask) {
+		home = ht->hash[j] & mask;
+
+		if (((j - home) & mask) < ((j - i) & mask))
+			continue;
+
+		put (ht, i, ht->table[j], ht->hash[j]);
+		i = j;
+	}
+
+	ht->table[i] = NULL;
+	set_ctrl (ht->ctrl, ht->size, i, HT_EMPTY);
+}
+
+void *ht_remove (struct ht *ht, const void *o)
+{
+	const size_t i = get_slot (ht, o, ht->type->hash (o));
+	void *item;
+
+	if ((item = ht_at (ht, i)) == NULL)
+		return NULL;
+
+	--ht->count;
+
+	if (i < ht->size)
+		shift (ht, i);
+	else
+		ht->old_table[i - ht->size] = NULL;  /* as moved one */
+
+	return item;
+}
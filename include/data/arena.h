@@ -0,0 +1,39 @@
+/*
+ * Arena Allocator
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DATA_ARENA_H
+#define DATA_ARENA_H  1
+
+#include <stddef.h>
+
+/*
+ * Objects are allocated one after another from big blocks and are
+ * released all at once by arena_fini. Block size doubles from
+ * ARENA_MIN up to ARENA_MAX, bigger objects get blocks of their own.
+ */
+#define ARENA_ALIGN  16
+#define ARENA_MIN    4096
+#define ARENA_MAX    (1 << 20)
+
+struct arena_block;
+
+struct arena {
+	struct arena_block *block;  /* list of blocks, current first */
+	char *next, *end;           /* free space of current block   */
+	size_t size;                /* size of next block            */
+	size_t count;               /* number of allocated objects   */
+};
+
+void arena_init (struct arena *o);
+void arena_fini (struct arena *o);
+
+/* returns memory aligned to ARENA_ALIGN or NULL on error */
+void *arena_alloc (struct arena *o, size_t size);
+char *arena_strdup (struct arena *o, const char *s);
+
+#endif  /* DATA_ARENA_H */
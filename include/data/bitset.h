@@ -29,11 +29,29 @@ static inline void bitset_fini (struct bitset *o)
 	free (o->set);
 }
 
+static inline void bitset_clear (struct bitset *o)
+{
+	o->count = 0;
+}
+
 int bitset_eq (const void *a, const void *b);
 size_t bitset_hash (const void *o);
 
 int bitset_is_member (const struct bitset *o, size_t x);
 
+/* returns non-zero if a ∩ b is not empty */
+int bitset_meet (const struct bitset *a, const struct bitset *b);
+
+/* returns number of members */
+size_t bitset_count (const struct bitset *o);
+
+/* returns first member not less than x or SIZE_MAX if none */
+size_t bitset_next (const struct bitset *o, size_t x);
+
+#define bitset_foreach(i, o)				\
+	for (i = bitset_next ((o), 0); i != SIZE_MAX;	\
+	     i = bitset_next ((o), i + 1))
+
 /* o = o U {x} */
 int bitset_add (struct bitset *o, size_t x);
 
@@ -20,6 +20,8 @@ struct da {
 int  da_init (struct da *da, const struct data_type *type);
 void da_fini (struct da *da);
 
+/* grows the array at once to hold count items */
+int da_reserve (struct da *da, size_t count);
 int da_insert (struct da *da, void *o);
 
 #endif  /* DATA_DA_H */
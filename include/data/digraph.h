@@ -0,0 +1,49 @@
+/*
+ * Relation Closure on Directed Graph
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DATA_DIGRAPH_H
+#define DATA_DIGRAPH_H  1
+
+#include <data/bitset.h>
+
+/*
+ * Relation is an unordered multiset of pairs (from, to) over vertices
+ * numbered from zero.
+ */
+struct relation {
+	size_t count, size;  /* number of pairs and number allocated */
+	size_t (*pair)[2];
+};
+
+static inline void relation_init (struct relation *o)
+{
+	o->count = 0;
+	o->size  = 0;
+	o->pair  = NULL;
+}
+
+static inline void relation_fini (struct relation *o)
+{
+	free (o->pair);
+}
+
+int relation_add (struct relation *o, size_t from, size_t to);
+
+/*
+ * The digraph function replaces each of count sets F(x) with union of
+ * F(y) for all vertices y reachable from x via relation R, including x
+ * itself. Every strongly connected component is processed once
+ * (DeRemer and Pennello), thus the function takes time linear in the
+ * size of the relation. Stack usage does not depend on the graph.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int digraph (const struct relation *R, size_t count, struct bitset *F);
+
+#endif  /* DATA_DIGRAPH_H */
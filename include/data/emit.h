@@ -0,0 +1,62 @@
+/*
+ * Buffered Text Emitter
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DATA_EMIT_H
+#define DATA_EMIT_H  1
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Text is collected in a buffer of EMIT_SIZE bytes and passed to the
+ * stream by whole blocks, thus stdio writes them directly without
+ * formatting and copying. Write errors are sticky and are reported by
+ * emit_fini.
+ */
+#define EMIT_SIZE  (64 * 1024)
+
+struct emit {
+	FILE *f;
+	char *next;      /* free space of buffer */
+	int error;
+	char buf[EMIT_SIZE];
+};
+
+void emit_init (struct emit *o, FILE *f);
+
+/* flushes buffer, returns non-zero on success and zero on write error */
+int  emit_fini  (struct emit *o);
+void emit_flush (struct emit *o);
+
+static inline void emit_mem (struct emit *o, const void *s, size_t len)
+{
+	if ((size_t) (o->buf + EMIT_SIZE - o->next) < len) {
+		emit_flush (o);
+
+		if (len > EMIT_SIZE) {
+			o->error |= fwrite (s, 1, len, o->f) != len;
+			return;
+		}
+	}
+
+	memcpy (o->next, s, len);
+	o->next += len;
+}
+
+static inline void emit_str (struct emit *o, const char *s)
+{
+	emit_mem (o, s, strlen (s));
+}
+
+/* emits string literal */
+#define emit_lit(o, s)  emit_mem ((o), s, sizeof (s) - 1)
+
+/* emits decimal representation of x */
+void emit_size (struct emit *o, size_t x);
+
+#endif  /* DATA_EMIT_H */
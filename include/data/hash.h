@@ -10,7 +10,43 @@
 #define DATA_HASH_H  1
 
 #include <stddef.h>
+#include <stdint.h>
 
-size_t hash (size_t hash, const void *data, size_t size);
+/*
+ * Seed of hashes of data types (atoms, atom sequences, strings), zero
+ * by default. It should be changed before any hash table is filled.
+ */
+extern size_t hash_seed;
+
+/*
+ * The hash function mixes data into the seed a 64-bit word at a time.
+ * The hash_string function returns hash (seed, s, strlen (s)) in one
+ * pass over the string.
+ */
+size_t hash (size_t seed, const void *data, size_t size);
+size_t hash_string (size_t seed, const char *s);
+
+/* mixes one word into hash state, state should be finalized by hash_mix */
+static inline size_t hash_step (size_t state, size_t x)
+{
+	uint64_t h = state + x * 0xc2b2ae3d27d4eb4fULL;
+
+	h = (h << 31) | (h >> 33);
+	return h * 0x9e3779b185ebca87ULL;
+}
+
+/* integer finalizer (MurmurHash3 fmix64) */
+static inline size_t hash_mix (size_t x)
+{
+	uint64_t h = x;
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
 
 #endif  /* DATA_HASH_H */
@@ -11,10 +11,44 @@
 
 #include <data/type.h>
 
+/*
+ * Control byte of a slot is HT_EMPTY for free slot or 7-bit tag of hash
+ * of its item with the high bit set. Control bytes of first HT_GROUP - 1
+ * slots are cloned after the end of the control array, thus a group of
+ * HT_GROUP control bytes can be read at any slot. Probing compares tags
+ * of the whole group at once, the eq function is called on tag matches
+ * only.
+ *
+ * Full hash of every item is stored next to its slot: resize and table
+ * hash never call the hash function of the data type, and items with
+ * different hashes are rejected before the eq call.
+ *
+ * In HT_INCREMENTAL mode resize allocates a new table and leaves items
+ * in the old one, every insert then moves HT_STEP slots of the old
+ * table to the new one. Lookups probe both tables, item in the old
+ * table has index size + its slot in the old table.
+ */
+#define HT_EMPTY  0
+#define HT_GROUP  16
+#define HT_STEP   8
+
+enum ht_flags {
+	HT_INCREMENTAL = 1,
+};
+
 struct ht {
 	const struct data_type *type;
+	unsigned flags;
 	size_t count, size;
 	void **table;
+	size_t *hash;         /* hashes of items by slot        */
+	unsigned char *ctrl;  /* size + HT_GROUP control bytes */
+
+	/* table being moved in incremental mode */
+	size_t old_size, moved;
+	void **old_table;
+	size_t *old_hash;
+	unsigned char *old_ctrl;
 };
 
 int  ht_init (struct ht *ht, const struct data_type *type);
@@ -27,8 +61,41 @@ size_t ht_index (const struct ht *ht, const void *o);
 void *ht_lookup (const struct ht *ht, const void *o);
 int ht_insert (struct ht *ht, void *o);
 
-#define ht_foreach(i, o, ht)				\
-	for (i = 0; i < (ht)->size; ++i)		\
-		if (((o) = (ht)->table[i]) != NULL)
+/*
+ * The ht_reserve function grows the table at once to hold count items
+ * without further resizes, pending incremental move is completed.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int ht_reserve (struct ht *ht, size_t count);
+
+/*
+ * The ht_insert_many function reserves space for count items and
+ * inserts them in order. Items before the failed one stay inserted.
+ *
+ * Returns non-zero on success or zero on error, errno is set to EEXIST
+ * if item is already in the table.
+ */
+int ht_insert_many (struct ht *ht, void **o, size_t count);
+
+/*
+ * The ht_remove function removes item equal to o from the table, the
+ * item is not freed. Items following it in the probe sequence may move
+ * back, thus items should not be removed inside of ht_foreach.
+ *
+ * Returns the removed item or NULL if there is no such item.
+ */
+void *ht_remove (struct ht *ht, const void *o);
+
+/* returns item at index or NULL */
+static inline void *ht_at (const struct ht *ht, size_t i)
+{
+	return i < ht->size ? ht->table[i] : ht->old_table[i - ht->size];
+}
+
+#define ht_foreach(i, o, ht)					\
+	for (i = 0; i < (ht)->size + (ht)->old_size; ++i)	\
+		if (((o) = ht_at ((ht), i)) != NULL)
 
 #endif  /* DATA_HT_H */
@@ -0,0 +1,40 @@
+/*
+ * Lexical Scanner to Code Conversion
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LEXER_CODE_H
+#define LEXER_CODE_H  1
+
+#include <stdio.h>
+#include <lexer/dfa.h>
+
+/*
+ * The lexer_header_code function emits declarations of scanner: token
+ * value and context from specification, lexer_buf interface and token
+ * enumeration LEXER_<NAME>. Generic buffered input of lexer.h is not
+ * generated.
+ *
+ * Returns non-zero on success or zero in case of write error.
+ */
+int lexer_header_code (const struct lexer_spec *o, FILE *f);
+
+/*
+ * The lexer_table_code function emits lexer_buf_process driven by
+ * transition table over equivalence classes of bytes, the
+ * lexer_direct_code function emits it as goto-based code with label
+ * per state. Both scanners match the longest token and return the
+ * first rule on tie, ignored tokens are skipped. Actions see the lexeme
+ * between o->start and o->stop, NUL-terminated copy of it named data
+ * is made only for actions referring to it.
+ *
+ * Return non-zero on success or zero in case of memory allocation or
+ * write error.
+ */
+int lexer_table_code  (const struct lexer_dfa *o, FILE *f);
+int lexer_direct_code (const struct lexer_dfa *o, FILE *f);
+
+#endif  /* LEXER_CODE_H */
@@ -0,0 +1,68 @@
+/*
+ * Lexical Scanner Automaton
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LEXER_DFA_H
+#define LEXER_DFA_H  1
+
+#include <lexer/spec.h>
+
+/*
+ * Minimal DFA over equivalence classes of bytes. State 0 is the dead
+ * state, state 1 is the start one. Class 0 consists of NUL byte only,
+ * the end of input, and leads to the dead state from any state.
+ *
+ * The next state of s on byte c is next[s * nclasses + class[c]],
+ * accept[s] is the token of the first rule matched in state s or zero.
+ */
+struct lexer_dfa {
+	const struct lexer_spec *spec;
+	size_t nstates, nclasses;
+	unsigned char class[256];
+	size_t *next;
+	size_t *accept;
+};
+
+/*
+ * The lexer_dfa_init function builds minimal DFA for rules of the
+ * specification which should outlive the automaton.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int  lexer_dfa_init (struct lexer_dfa *o, const struct lexer_spec *spec);
+void lexer_dfa_fini (struct lexer_dfa *o);
+
+/*
+ * The lexer_dfa_scan function matches the longest token at the start of
+ * NUL-terminated input and stores its length.
+ *
+ * Returns token, zero at the end of input or -1 if no rule matches.
+ */
+static inline
+int lexer_dfa_scan (const struct lexer_dfa *o, const char *in, size_t *len)
+{
+	const unsigned char *p = (const void *) in, *stop = p;
+	size_t s = 1, token = 0;
+
+	if (*p == '\0')
+		return 0;
+
+	while ((s = o->next[s * o->nclasses + o->class[*p]]) != 0) {
+		++p;
+
+		if (o->accept[s] != 0) {
+			token = o->accept[s];
+			stop  = p;
+		}
+	}
+
+	*len = stop - (const unsigned char *) in;
+	return token != 0 ? (int) token : -1;
+}
+
+#endif  /* LEXER_DFA_H */
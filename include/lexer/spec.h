@@ -0,0 +1,91 @@
+/*
+ * Lexical Scanner Specification
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef LEXER_SPEC_H
+#define LEXER_SPEC_H  1
+
+#include <data/arena.h>
+#include <data/da.h>
+
+/*
+ * Regular expression tree: set of bytes, concatenation or alternation
+ * of two expressions, or repetition of the first one. NUL byte is the
+ * end of input and never is a member of set.
+ */
+enum lexer_re_kind {
+	LEXER_RE_SET,
+	LEXER_RE_CAT,
+	LEXER_RE_ALT,
+	LEXER_RE_STAR,
+	LEXER_RE_PLUS,
+	LEXER_RE_OPT,
+};
+
+struct lexer_re {
+	enum lexer_re_kind kind;
+	struct lexer_re *a, *b;
+	unsigned char set[32];  /* bitmap of bytes for LEXER_RE_SET */
+};
+
+static inline int lexer_re_has (const struct lexer_re *o, unsigned c)
+{
+	return (o->set[c / 8] >> (c % 8)) & 1;
+}
+
+/*
+ * Token rule: token number is the rule index plus one, ignored tokens
+ * are skipped by scanner, action is executed on the token with the
+ * lexeme copied to NUL-terminated data.
+ */
+struct lexer_rule {
+	const char *name;
+	const char *action;  /* NULL if rule has no action */
+	int ignore;
+	struct lexer_re *re;
+};
+
+struct lexer_spec {
+	struct arena arena;      /* names, code and expressions */
+	const char *extra;       /* code before declarations    */
+	const char *type;        /* members of token value      */
+	const char *context;     /* members of scanner context  */
+	struct da rules;
+	size_t line;             /* line of syntax error        */
+};
+
+int  lexer_spec_init (struct lexer_spec *o);
+void lexer_spec_fini (struct lexer_spec *o);
+
+static inline
+const struct lexer_rule *lexer_spec_rule (const struct lexer_spec *o,
+					  size_t i)
+{
+	return o->rules.table[i];
+}
+
+/*
+ * The lexer_spec_parse function loads NUL-terminated specification in
+ * the lexer.g format:
+ *
+ *	% extra   { code }
+ *	% type    { members }
+ *	% context { members }
+ *
+ *	name[*] : expression [{ action }] [;]
+ *
+ * Rule ends with semicolon or with a line which does not start with
+ * blank. Expression consists of quoted strings 'abc', bracket classes
+ * [a-z] and [^a-z], groups and postfix operators *, + and ?, joined by
+ * concatenation and alternation |. Comments start with #.
+ *
+ * Returns non-zero on success or zero on error, errno is set to EINVAL
+ * on syntax error with line set to its line number, or to ENOMEM.
+ */
+int lexer_spec_parse (struct lexer_spec *o, const char *text);
+
+#endif  /* LEXER_SPEC_H */
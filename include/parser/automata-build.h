@@ -11,6 +11,23 @@
 
 #include <parser/automata.h>
 
+/*
+ * The automata_build function builds LR(0) automata for the numbered
+ * grammar (see grammar_number).
+ *
+ * Returns non-zero on success or zero on error.
+ */
 int automata_build (struct automata *a, const struct grammar *g);
 
+/*
+ * The automata_build_lr1 function builds LR(1) automata for the
+ * numbered grammar. Lookaheads of kernel items and reductions are
+ * stored in states (see state_lookahead). States with the same kernel
+ * are merged when weakly compatible (Pager) unless AUTOMATA_CANONICAL
+ * flag is set.
+ *
+ * Returns non-zero on success or zero on error.
+ */
+int automata_build_lr1 (struct automata *a, const struct grammar *g);
+
 #endif  /* PARSER_AUTOMATA_BUILD_H */
@@ -12,7 +12,30 @@
 #include <stdio.h>
 #include <parser/automata.h>
 
-void state_code    (const struct state *o,    FILE *f);
-void automata_code (const struct automata *o, FILE *f);
+/*
+ * The automata_code function emits recursive ascent parser: function
+ * per state, conflicts are reported to stderr. Output is buffered and
+ * passed to the stream by big blocks.
+ *
+ * The code is to be included after definitions of distinct non-zero
+ * TOKEN_x for every terminal x, distinct positive NT_x for every
+ * non-terminal x and of struct parser with members:
+ *
+ *	int  (*lex)   (struct parser *c);
+ *	void (*unlex) (struct parser *c);
+ *
+ * The lex member returns the next token: TOKEN_x of terminal x or zero
+ * at the end of input. The unlex member pushes back the token returned
+ * by the last call of lex, thus the next call of lex returns it again:
+ * reduction decided on lookahead leaves the token to the state which
+ * shifts it. Only one token is pushed back between calls of lex.
+ *
+ * The emitted parse function takes struct parser pointer and returns
+ * NT_x of the start symbol on success or -1 on syntax error.
+ *
+ * Returns non-zero on success or zero in case of memory allocation or
+ * write error.
+ */
+int automata_code (const struct automata *o, FILE *f);
 
 #endif  /* PARSER_AUTOMATA_CODE_H */
@@ -0,0 +1,24 @@
+/*
+ * LALR(1) Lookahead Calculation
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PARSER_AUTOMATA_LALR_H
+#define PARSER_AUTOMATA_LALR_H  1
+
+#include <parser/automata.h>
+
+/*
+ * The automata_lalr function calculates LALR(1) lookahead sets for all
+ * reductions of the built LR(0) automata (see state_lookahead) with
+ * the method of DeRemer and Pennello.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int automata_lalr (struct automata *a);
+
+#endif  /* PARSER_AUTOMATA_LALR_H */
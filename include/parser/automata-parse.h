@@ -0,0 +1,56 @@
+/*
+ * LR Parser Runtime
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PARSER_AUTOMATA_PARSE_H
+#define PARSER_AUTOMATA_PARSE_H  1
+
+#include <parser/automata-table.h>
+
+/*
+ * Lexer returns the next terminal id of the grammar, nterms on the end
+ * of input or negative value on error, and stores the token value.
+ */
+typedef int parser_lex_fn (void *cookie, void **value);
+
+/*
+ * Reduce action returns the value of rule non-terminal from the values
+ * of its production symbols.
+ */
+typedef void *parser_reduce_fn (void *cookie, const struct rule *r,
+				void **args);
+
+/*
+ * Parser keeps state and value stacks between runs: they grow
+ * geometrically on demand and never shrink.
+ */
+struct automata_parser {
+	const struct automata_table *table;
+	size_t size;    /* allocated stack depth */
+	size_t *state;
+	void **value;
+
+	parser_lex_fn *lex;
+	parser_reduce_fn *reduce;  /* NULL if values are not needed */
+	void *cookie;
+};
+
+int  automata_parser_init (struct automata_parser *o,
+			   const struct automata_table *t);
+void automata_parser_fini (struct automata_parser *o);
+
+/*
+ * The automata_parse function parses the token stream with the tables
+ * and stores the value of the start symbol into result (if not NULL).
+ *
+ * Returns non-zero on success or zero on error: errno is set to EINVAL
+ * on syntax error or lexer error and to ENOMEM on memory allocation
+ * error.
+ */
+int automata_parse (struct automata_parser *o, void **result);
+
+#endif  /* PARSER_AUTOMATA_PARSE_H */
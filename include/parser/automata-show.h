@@ -18,6 +18,11 @@ void item_set_show (const struct ht *o,   FILE *f);
 void arrow_show     (const struct arrow *o, FILE *f);
 void arrow_set_show (const struct ht *o,    FILE *f);
 
+void lookahead_show (const struct lookahead *o, const struct grammar *g,
+		     FILE *f);
+
+void state_items_show (const struct state *o, FILE *f);
+
 void state_show    (const struct state *o,    FILE *f);
 void automata_show (const struct automata *o, FILE *f);
 
@@ -0,0 +1,88 @@
+/*
+ * Compressed LR Parsing Tables
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PARSER_AUTOMATA_TABLE_H
+#define PARSER_AUTOMATA_TABLE_H  1
+
+#include <stdio.h>
+#include <parser/automata.h>
+
+/*
+ * ACTION and GOTO tables packed into one comb vector (row displacement).
+ * Row r of the vector is ACTION row of state r for r < nstates, indexed
+ * by terminal id (nterms is the end of input), or GOTO column of
+ * non-terminal r - nstates indexed by state. Entry of row r at column x
+ * is found at value[base[r] + x] if check[base[r] + x] equals r,
+ * otherwise the row default is used.
+ *
+ * Action is zero for error, s + 1 for shift to state s, and -(r + 1)
+ * for reduce by rule r. Default action of a state is its most frequent
+ * reduction, default goto of a non-terminal is its most frequent target.
+ * Input is accepted on the end of input after reduction to the start
+ * non-terminal in the start state.
+ */
+struct automata_table {
+	const struct grammar *grammar;
+	size_t nterms, nsymbols, nstates, nrules;
+	size_t start;       /* start state             */
+	size_t accept;      /* start non-terminal index */
+
+	size_t *rule_nt;    /* non-terminal index by rule id    */
+	size_t *rule_len;   /* production length by rule id     */
+	int *defact;        /* default action by state          */
+	size_t *defgoto;    /* default goto by non-terminal, or
+			       nstates if there is no one       */
+
+	size_t nrows, size;
+	size_t *base;       /* displacement by row              */
+	int *value;         /* packed actions and gotos         */
+	size_t *check;      /* row of entry, or SIZE_MAX if free */
+	size_t entries;     /* number of packed entries         */
+};
+
+/*
+ * The automata_table_init function builds tables of the automata: for
+ * states with lookaheads (see automata_lalr and automata_build_lr1)
+ * reductions are done on lookahead tokens, otherwise on any token not
+ * shifted. Shift wins in shift/reduce conflict, first reduction wins in
+ * reduce/reduce one. States keep their numbers, see
+ * automata_insert_state.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int  automata_table_init (struct automata_table *o, const struct automata *a);
+void automata_table_fini (struct automata_table *o);
+
+static inline int
+automata_table_action (const struct automata_table *o, size_t s, size_t t)
+{
+	const size_t i = o->base[s] + t;
+
+	return i < o->size && o->check[i] == s ? o->value[i] : o->defact[s];
+}
+
+static inline size_t
+automata_table_goto (const struct automata_table *o, size_t s, size_t nt)
+{
+	const size_t r = o->nstates + nt, i = o->base[r] + s;
+
+	return i < o->size && o->check[i] == r ? (size_t) o->value[i] :
+						 o->defgoto[nt];
+}
+
+/*
+ * The automata_table_code function emits tables and iterative table
+ * driven parser with the same interface as automata_code.
+ *
+ * Returns non-zero on success or zero in case of memory allocation or
+ * write error.
+ */
+int automata_table_code (const struct automata_table *o, FILE *f);
+
+#endif  /* PARSER_AUTOMATA_TABLE_H */
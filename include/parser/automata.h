@@ -9,47 +9,141 @@
 #ifndef PARSER_AUTOMATA_H
 #define PARSER_AUTOMATA_H  1
 
+#include <data/arena.h>
+#include <data/bitset.h>
+#include <data/da.h>
 #include <data/ht.h>
+#include <data/seq.h>
 #include <parser/grammar.h>
 
-/* item key = (rule, pos) */
+/* item key = id = rule->item + pos */
 struct item {
 	const struct rule *rule;  /* owned by grammar */
 	size_t pos;
+	size_t id;
 };
 
-/* arrow key = on */
+/* arrow key = on->id */
 struct arrow {
 	const struct symbol *on;  /* owned by grammar  */
 	struct state *to;         /* should be transferred to automata */
+	size_t index;             /* non-terminal transition number */
+};
+
+/*
+ * lookahead key = item
+ *
+ * Lookahead set contains terminal ids, grammar->nterms denotes end of
+ * input.
+ */
+struct lookahead {
+	const struct item *item;  /* owned by automata */
+	struct bitset set;
 };
 
 struct automata;
 
-/* state key = items */
+/*
+ * state key = (kernel items, split)
+ *
+ * Closure items are not stored in state, see state_closure. LR(1)
+ * states with the same kernel which cannot be merged are distinguished
+ * by split number.
+ */
 struct state {
+	struct state *next;         /* link in build queue */
+	int queued;                 /* in build queue */
+	size_t index;               /* number in order of discovery */
+	size_t split;
 	struct automata *automata;  /* state owner */
-	struct ht items;   /* unordered set of items owned by automata */
+	struct ht items;   /* unordered set of kernel items */
+	struct bitset set; /* set of kernel item ids, in bitset mode only */
 	struct ht arrows;  /* unordered set of arrows */
+	struct ht lookaheads;  /* unordered set of lookaheads */
 };
 
+SEQ_DECLARE (state)
+
+/* states live in automata arena, state_free keeps state for reuse */
 struct state *state_alloc (struct automata *a);
 void state_free (void *o);
 
 int state_add_item (struct state *o, const struct rule *rule, size_t pos);
+
+/*
+ * The state_add_items function adds distinct kernel items to the state
+ * at once, the item set is allocated for all of them beforehand.
+ *
+ * Returns non-zero on success or zero on error.
+ */
+int state_add_items (struct state *o, const struct item **items,
+		     size_t count);
 struct arrow *state_add_arrow (struct state *o, const struct symbol *on);
 
+struct lookahead *state_add_lookahead (struct state *o,
+				       const struct item *item);
+const struct bitset *state_lookahead (const struct state *o,
+				      const struct item *item);
+
+/*
+ * The state_closure function replaces content of the set with ids of
+ * kernel and closure items of the state.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int state_closure (const struct state *o, struct bitset *set);
+
+enum automata_flags {
+	AUTOMATA_BITSET	   = 1,  /* identify states by bitsets of kernel ids */
+	AUTOMATA_CANONICAL = 2,  /* do not merge LR(1) states */
+};
+
 struct automata {
-	struct ht items;   /* unordered set of items  */
-	struct ht states;  /* unordered set of states */
+	unsigned flags;
+	const struct grammar *grammar;
+	struct arena arena;  /* states, arrows and lookaheads */
+	struct state *spare; /* freed states to reuse */
+	struct item *items;  /* items by id */
+	struct ht states;    /* unordered set of states */
+	struct da state;     /* states by index */
 	const struct state *start;
+
+	struct bitset *closure;  /* closure items by non-terminal */
+	size_t closure_joins;    /* number of cached closures used */
 };
 
 int  automata_init (struct automata *o);
 void automata_fini (struct automata *o);
 
+/*
+ * The automata_prepare function fills item table for the numbered
+ * grammar (see grammar_number) and calculates closure items for every
+ * non-terminal.
+ *
+ * Returns non-zero on success or zero on error.
+ */
+int automata_prepare (struct automata *o, const struct grammar *g);
+
 const struct item *automata_add_item (struct automata *o,
 				      const struct rule *rule, size_t pos);
 const struct state *automata_add_state (struct automata *o, struct state *s);
 
+/*
+ * The automata_insert_state function inserts the new state into state
+ * set and numbers it: states are numbered in order of insertion, that
+ * is breadth-first discovery order of automata_build, independent of
+ * hash values and memory layout.
+ *
+ * Returns non-zero on success or zero on error.
+ */
+int automata_insert_state (struct automata *o, struct state *s);
+
+/* returns state by index */
+static inline struct state *
+automata_state (const struct automata *o, size_t index)
+{
+	return o->state.table[index];
+}
+
 #endif  /* PARSER_AUTOMATA_H */
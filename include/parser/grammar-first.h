@@ -0,0 +1,70 @@
+/*
+ * Context-Free Grammar Analysis
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PARSER_GRAMMAR_FIRST_H
+#define PARSER_GRAMMAR_FIRST_H  1
+
+#include <data/bitset.h>
+#include <parser/grammar.h>
+
+/*
+ * Nullable, FIRST and FOLLOW sets of the numbered grammar. Sets of
+ * terminals contain dense terminal ids, end of input is represented by
+ * id nterms. All functions take time linear in the size of grammar and
+ * resulting sets.
+ */
+
+/*
+ * The grammar_nullable function replaces content of the set with ids
+ * of symbols of the numbered grammar which derive empty string.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int grammar_nullable (const struct grammar *o, struct bitset *set);
+
+/*
+ * The grammar_first function calculates FIRST sets of terminal ids for
+ * every symbol of the numbered grammar: first is an array of nsymbols
+ * initialized bitsets indexed by symbol id, nullable is the set of
+ * nullable symbols.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int grammar_first (const struct grammar *o, const struct bitset *nullable,
+		   struct bitset *first);
+
+/*
+ * The grammar_follow function calculates FOLLOW sets of terminal ids
+ * for every symbol of the numbered grammar: follow is an array of
+ * nsymbols initialized bitsets indexed by symbol id, FOLLOW of the
+ * start symbol includes the end of input.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int grammar_follow (const struct grammar *o, const struct bitset *nullable,
+		    const struct bitset *first, struct bitset *follow);
+
+/* returns non-zero if NULL-terminated symbol sequence is nullable */
+int grammar_seq_is_nullable (const struct symbol *const *seq,
+			     const struct bitset *nullable);
+
+/*
+ * The grammar_seq_first function joins FIRST set of NULL-terminated
+ * symbol sequence to the set.
+ *
+ * Returns non-zero on success or zero in case of memory allocation
+ * error.
+ */
+int grammar_seq_first (const struct symbol *const *seq,
+		       const struct bitset *nullable,
+		       const struct bitset *first, struct bitset *set);
+
+#endif  /* PARSER_GRAMMAR_FIRST_H */
@@ -9,12 +9,22 @@
 #ifndef PARSER_GRAMMAR_H
 #define PARSER_GRAMMAR_H  1
 
+#include <data/arena.h>
 #include <data/ht.h>
 
 struct grammar {
+	struct arena arena;  /* names, symbols and rules */
 	struct ht names;
 	struct ht symbols;
 	struct symbol *start;
+
+	/* dense numbering, see grammar_number */
+	size_t nterms;     /* number of terminals      */
+	size_t nsymbols;   /* number of symbols        */
+	size_t nrules;     /* number of rules          */
+	size_t nitems;     /* number of LR(0) items    */
+	struct symbol **symbol;  /* symbols by id */
+	struct rule **rule;      /* rules by id   */
 };
 
 /*
@@ -23,11 +33,13 @@ struct grammar {
  * 1. Names are not owned by symbol.
  * 2. Distinct name pointers point to distinct names.
  * 3. Rules are owned by symbol.
+ * 4. Terminals are numbered before non-terminals.
  */
 
 struct symbol {
 	const char *name;
 	struct ht *rules;  /* NULL for terminals */
+	size_t id;
 };
 
 /*
@@ -35,19 +47,49 @@ struct symbol {
  *
  * 1. Symbols are not owned by rule.
  * 2. Distinct symbol pointers point to distinct symbols.
+ * 3. Item (rule, pos) has id = item + pos.
  */
 
 struct rule {
 	struct symbol *nt;
+	size_t id;
+	size_t item;  /* id of the first item of rule */
 	const struct symbol *prod[1];  /* NULL-terminated sequence */
 };
 
 int  grammar_init (struct grammar *o);
 void grammar_fini (struct grammar *o);
 
+/* preallocates space for count names and symbols */
+int grammar_reserve (struct grammar *o, size_t count);
+
 const char    *grammar_add_name   (struct grammar *o, const char *name);
 struct symbol *grammar_add_symbol (struct grammar *o, const char *name);
 
-int symbol_insert_rule (struct symbol *o, struct rule *rule);
+/* returns symbol with the name or NULL if there is no such symbol */
+struct symbol *grammar_lookup_symbol (const struct grammar *o,
+				      const char *name);
+
+/*
+ * The grammar_alloc function allocates memory released by grammar_fini,
+ * rules of the grammar should be allocated by it.
+ */
+void *grammar_alloc (struct grammar *o, size_t size);
+
+int symbol_insert_rule (struct grammar *g, struct symbol *o,
+			struct rule *rule);
+
+/*
+ * The grammar_number function assigns dense identifiers to symbols,
+ * rules and items of the loaded grammar. Terminals are numbered first
+ * in order of appearance, then non-terminals, rules are numbered in
+ * order of their non-terminals and insertion. Repeated call does nothing
+ * if no symbols or rules were added since numbering, otherwise it fails:
+ * the grammar is not renumbered.
+ *
+ * Returns non-zero on success or zero on error, errno is set to EBUSY
+ * if the grammar was changed after numbering.
+ */
+int grammar_number (struct grammar *o);
 
 #endif  /* PARSER_GRAMMAR_H */
@@ -0,0 +1,446 @@
+/*
+ * Lexical Scanner to Code Conversion
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lexer/code.h>
+
+static void token_name (const struct lexer_rule *r, FILE *f)
+{
+	const char *p;
+
+	fputs ("LEXER_", f);
+
+	for (p = r->name; *p != '\0'; ++p)
+		fputc (*p == '-' ? '_' : toupper ((unsigned char) *p), f);
+}
+
+/* returns non-zero if all the output reached the stream */
+static int stream_ok (FILE *f)
+{
+	return fflush (f) == 0 && !ferror (f);
+}
+
+int lexer_header_code (const struct lexer_spec *o, FILE *f)
+{
+	size_t i;
+
+	fprintf (f, "#ifndef LEXER_H\n"
+		    "#define LEXER_H  1\n\n"
+		    "#include <stddef.h>\n");
+
+	if (o->extra != NULL)
+		fprintf (f, "%s\n", o->extra);
+
+	fprintf (f, "\ntypedef char lexer_input_t;\n\n"
+		    "union lexer_type {\n\t%s\n};\n\n",
+		 o->type != NULL ? o->type : "int none;");
+
+	fprintf (f, "struct lexer_buf {\n"
+		    "\tconst lexer_input_t *start, *stop;  /* matched item */\n");
+
+	if (o->context != NULL)
+		fprintf (f, "\t%s\n", o->context);
+
+	fprintf (f, "};\n\n"
+		    "void lexer_buf_init (struct lexer_buf *o, "
+		    "const lexer_input_t *buf);\n"
+		    "int  lexer_buf_process (struct lexer_buf *o, "
+		    "union lexer_type *value);\n\n"
+		    "enum lexer_token {\n");
+
+	for (i = 0; i < o->rules.count; ++i) {
+		fputc ('\t', f);
+		token_name (lexer_spec_rule (o, i), f);
+		fprintf (f, i == 0 ? " = 1,\n" : ",\n");
+	}
+
+	fprintf (f, "};\n\n"
+		    "#endif  /* LEXER_H */\n");
+
+	return stream_ok (f);
+}
+
+static void prologue_code (FILE *f)
+{
+	fprintf (f, "#include <string.h>\n"
+		    "#include \"lexer.h\"\n\n"
+		    "void lexer_buf_init (struct lexer_buf *o, "
+		    "const lexer_input_t *buf)\n"
+		    "{\n"
+		    "\to->start = o->stop = buf;\n"
+		    "}\n\n"
+		    "#define DEFINE_DATA\t\t\t\t\t\t\t\\\n"
+		    "\tconst size_t len = o->stop - o->start;\t\t\t\t\\\n"
+		    "\tlexer_input_t data[len + 1];\t\t\t\t\t\\\n"
+		    "\t\t\t\t\t\t\t\t\t\\\n"
+		    "\tmemcpy (data, o->start, len * sizeof (lexer_input_t));"
+		    "\t\t\\\n"
+		    "\tdata[len] = 0\n\n");
+}
+
+static int is_word (int c)
+{
+	return isalnum (c) || c == '_';
+}
+
+/* returns non-zero if action refers to copy of lexeme named data */
+static int uses_data (const char *action)
+{
+	const char *p;
+
+	for (p = action; (p = strstr (p, "data")) != NULL; p += 4)
+		if ((p == action || !is_word ((unsigned char) p[-1])) &&
+		    !is_word ((unsigned char) p[4]))
+			return 1;
+
+	return 0;
+}
+
+/* emits code of accepted token: skip, or execute action and return */
+static void accept_code (const struct lexer_spec *o, size_t token,
+			 const char *indent, FILE *f)
+{
+	const struct lexer_rule *r = lexer_spec_rule (o, token - 1);
+
+	if (r->ignore) {
+		fprintf (f, "%sgoto start;\n", indent);
+		return;
+	}
+
+	if (r->action != NULL && uses_data (r->action))
+		fprintf (f, "%s{ DEFINE_DATA; %s }\n", indent, r->action);
+	else if (r->action != NULL)
+		fprintf (f, "%s{ %s }\n", indent, r->action);
+
+	fprintf (f, "%sreturn ", indent);
+	token_name (r, f);
+	fprintf (f, ";\n");
+}
+
+/* returns non-zero if scanner skips tokens of some rule */
+static int has_ignore (const struct lexer_spec *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->rules.count; ++i)
+		if (lexer_spec_rule (o, i)->ignore)
+			return 1;
+
+	return 0;
+}
+
+static const char *type_code (size_t max)
+{
+	return max <= 0xff   ? "unsigned char"  :
+	       max <= 0xffff ? "unsigned short" : "unsigned";
+}
+
+static void array_code (const size_t *p, size_t count, FILE *f)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+		fprintf (f, "%s%zu%s", i % 16 == 0 ? "\t" : " ", p[i],
+			 i + 1 == count ? "\n" : i % 16 == 15 ? ",\n" : ",");
+}
+
+int lexer_table_code (const struct lexer_dfa *o, FILE *f)
+{
+	const size_t k = o->nclasses;
+	size_t i, class[256];
+
+	prologue_code (f);
+
+	for (i = 0; i < 256; ++i)
+		class[i] = o->class[i];
+
+	fprintf (f, "static const unsigned char lexer_class[256] = {\n");
+	array_code (class, 256, f);
+
+	fprintf (f, "};\n\n/* next state by state * %zu + class */\n"
+		    "static const %s lexer_next[%zu] = {\n",
+		 k, type_code (o->nstates - 1), o->nstates * k);
+	array_code (o->next, o->nstates * k, f);
+
+	fprintf (f, "};\n\nstatic const %s lexer_accept[%zu] = {\n",
+		 type_code (o->spec->rules.count), o->nstates);
+	array_code (o->accept, o->nstates, f);
+
+	fprintf (f, "};\n\n"
+		    "int lexer_buf_process (struct lexer_buf *o, "
+		    "union lexer_type *value)\n"
+		    "{\n"
+		    "\tconst unsigned char *p;\n"
+		    "\tunsigned s;\n"
+		    "\tint token;\n"
+		    "%s"
+		    "\to->start = o->stop;\n\n"
+		    "\tif (*o->stop == 0)\n"
+		    "\t\treturn 0;\n\n"
+		    "\tfor (p = (const void *) o->stop, s = 1, token = -1;\n"
+		    "\t     (s = lexer_next[s * %zu + lexer_class[*p]]) != 0; ) {\n"
+		    "\t\t++p;\n\n"
+		    "\t\tif (lexer_accept[s] != 0) {\n"
+		    "\t\t\ttoken = lexer_accept[s];\n"
+		    "\t\t\to->stop = (const void *) p;\n"
+		    "\t\t}\n"
+		    "\t}\n\n"
+		    "\tswitch (token) {\n",
+		 has_ignore (o->spec) ? "start:\n" : "", k);
+
+	for (i = 0; i < o->spec->rules.count; ++i) {
+		fprintf (f, "\tcase ");
+		token_name (lexer_spec_rule (o->spec, i), f);
+		fprintf (f, ":\n");
+		accept_code (o->spec, i + 1, "\t\t", f);
+	}
+
+	fprintf (f, "\t}\n\n"
+		    "\treturn -1;\n"
+		    "}\n");
+
+	return stream_ok (f);
+}
+
+/*
+ * Direct code
+ */
+static int char_code (unsigned c, char *p)
+{
+	switch (c) {
+	case '\n':	return sprintf (p, "'\\n'");
+	case '\t':	return sprintf (p, "'\\t'");
+	case '\r':	return sprintf (p, "'\\r'");
+	case '\'':	return sprintf (p, "'\\''");
+	case '\\':	return sprintf (p, "'\\\\'");
+	}
+
+	if (c >= 0x20 && c < 0x7f)
+		return sprintf (p, "'%c'", c);
+
+	return sprintf (p, "%u", c);
+}
+
+/* returns number of comparisons to test membership by ranges */
+static size_t range_cost (const unsigned char *set, int in)
+{
+	size_t c, cost = 0;
+
+	for (c = 0; c < 256; ++c)
+		if (set[c] == in)
+			cost += c == 0 || set[c - 1] != in ? 1 :
+				c == 1 || set[c - 2] != in ? 1 : 0;
+
+	return cost;
+}
+
+/* formats test of HEAD against range or against its complement */
+static void range_code (unsigned from, unsigned to, int in, char *p)
+{
+	if (from == to) {
+		p += sprintf (p, in ? "HEAD == " : "HEAD != ");
+		char_code (from, p);
+		return;
+	}
+
+	p += sprintf (p, in ? "(HEAD >= " : "(HEAD < ");
+	p += char_code (from, p);
+	p += sprintf (p, in ? " && HEAD <= " : " || HEAD > ");
+	p += char_code (to, p);
+	sprintf (p, ")");
+}
+
+/*
+ * Emits condition of membership of HEAD in set as disjunction of ranges
+ * or as conjunction of ranges of complement whichever is shorter
+ */
+static void cond_code (const unsigned char *set, FILE *f)
+{
+	const int in = range_cost (set, 1) <= range_cost (set, 0);
+	char term[48];
+	size_t from, to, n, col = 12, len;
+
+	for (from = 0, n = 0; from < 256; from = to + 1) {
+		if (set[from] != in) {
+			to = from;
+			continue;
+		}
+
+		for (to = from; to + 1 < 256 && set[to + 1] == in; ++to) {}
+
+		range_code (from, to, in, term);
+		len = strlen (term);
+
+		if (n++ > 0) {
+			fprintf (f, in ? " ||" : " &&");
+
+			if (col + 4 + len > 72) {
+				fprintf (f, "\n\t    ");
+				col = 12;
+			}
+			else {
+				fprintf (f, " ");
+				col += 4;
+			}
+		}
+
+		fprintf (f, "%s", term);
+		col += len;
+	}
+}
+
+/*
+ * Marks states from which a state without token can be reached: the
+ * scanner should remember the last match there to return to it
+ */
+static unsigned char *mark_states (const struct lexer_dfa *o)
+{
+	const size_t k = o->nclasses;
+	unsigned char *mark;
+	size_t s, c, t;
+	int changed;
+
+	if ((mark = calloc (o->nstates, 1)) == NULL)
+		return NULL;
+
+	do
+		for (changed = 0, s = o->nstates - 1; s > 0; --s)
+			for (c = 1; c < k && !mark[s]; ++c)
+				if ((t = o->next[s * k + c]) != 0 &&
+				    (o->accept[t] == 0 || mark[t]))
+					mark[s] = changed = 1;
+	while (changed);
+
+	return mark;
+}
+
+/* returns non-zero if there is a transition to state t */
+static int reaches (const struct lexer_dfa *o, size_t t)
+{
+	size_t i;
+
+	for (i = 0; i < o->nstates * o->nclasses; ++i)
+		if (o->next[i] == t)
+			return 1;
+
+	return 0;
+}
+
+static void state_code (const struct lexer_dfa *o, size_t s,
+			const unsigned char *mark, int fail, FILE *f)
+{
+	const size_t k = o->nclasses;
+	unsigned char set[256];
+	size_t to, c, b, token = o->accept[s], moves = 0;
+
+	if (s != 1 || reaches (o, 1))
+		fprintf (f, "x_%zu:\n", s);
+
+	for (to = 1; to < o->nstates; ++to) {
+		for (b = 0, c = 0; b < 256; ++b)
+			c += set[b] = o->next[s * k + o->class[b]] == to;
+
+		if (c == 0)
+			continue;
+
+		if (moves++ == 0 && mark[s] && token != 0)
+			fprintf (f, "\tmark = o->stop;\n"
+				    "\ttoken = %zu;\n\n", token);
+
+		fprintf (f, "\tif (");
+		cond_code (set, f);
+		fprintf (f, ")\n\t\tGOTO (%zu);\n\n", to);
+	}
+
+	if (token != 0)
+		fprintf (f, "\tgoto t_%zu;\n", token);
+	else
+		fprintf (f, fail ? "\tgoto fail;\n" : "\treturn -1;\n");
+}
+
+int lexer_direct_code (const struct lexer_dfa *o, FILE *f)
+{
+	const struct lexer_spec *spec = o->spec;
+	unsigned char *mark, *used;
+	size_t i;
+	int fail = 0;
+
+	if ((mark = mark_states (o)) == NULL)
+		return 0;
+
+	/* tokens of shadowed rules are never accepted */
+	if ((used = calloc (spec->rules.count + 1, 1)) == NULL)
+		goto no_used;
+
+	/* 1 for accepted token, 2 if it is remembered for backtracking */
+	for (i = 1; i < o->nstates; ++i) {
+		used[o->accept[i]] |= mark[i] ? 3 : 1;
+		fail |= mark[i] && o->accept[i] != 0;
+	}
+
+	prologue_code (f);
+
+	fprintf (f, "#define HEAD\t\t(*(const unsigned char *) o->stop)\n"
+		    "#define NEXT\t\tdo { ++o->stop;\t\t\t} while (0)\n"
+		    "#define GOTO(label)\tdo { NEXT; goto x_ ## label;\t"
+		    "} while (0)\n\n"
+		    "int lexer_buf_process (struct lexer_buf *o, "
+		    "union lexer_type *value)\n"
+		    "{\n");
+
+	if (fail)
+		fprintf (f, "\tconst lexer_input_t *mark;\n"
+			    "\tint token;\n");
+
+	if (has_ignore (spec))
+		fprintf (f, "start:\n");
+
+	fprintf (f, "\to->start = o->stop;\n");
+
+	if (fail)
+		fprintf (f, "\tmark = NULL;\n"
+			    "\ttoken = 0;\n");
+
+	/* state 1 may be entered again inside of token */
+	fprintf (f, "\n\tif (HEAD == 0)\n\t\treturn 0;\n\n");
+
+	for (i = 1; i < o->nstates; ++i)
+		state_code (o, i, mark, fail, f);
+
+	for (i = 1; i <= spec->rules.count; ++i)
+		if (used[i]) {
+			fprintf (f, "t_%zu:\n", i);
+			accept_code (spec, i, "\t", f);
+		}
+
+	if (fail) {
+		fprintf (f, "fail:\n"
+			    "\tif (mark == NULL)\n"
+			    "\t\treturn -1;\n\n"
+			    "\to->stop = mark;\n\n"
+			    "\tswitch (token) {\n");
+
+		for (i = 1; i <= spec->rules.count; ++i)
+			if (used[i] & 2)
+				fprintf (f, "\tcase %zu: goto t_%zu;\n", i, i);
+
+		fprintf (f, "\t}\n\n"
+			    "\treturn -1;\n");
+	}
+
+	fprintf (f, "}\n");
+	free (used);
+	free (mark);
+	return stream_ok (f);
+no_used:
+	free (mark);
+	return 0;
+}
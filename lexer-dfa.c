@@ -0,0 +1,563 @@
+/*
+ * Lexical Scanner Automaton
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <data/bitset.h>
+#include <data/hash.h>
+#include <data/ht.h>
+#include <lexer/dfa.h>
+
+/*
+ * Thompson NFA: node has transition on byte set to the next node and up
+ * to two empty transitions
+ */
+#define NFA_NONE  SIZE_MAX
+
+struct nfa_node {
+	const struct lexer_re *on;
+	size_t next, eps[2];
+	size_t token;
+};
+
+struct nfa {
+	struct nfa_node *node;
+	size_t count, size;
+};
+
+static size_t nfa_add (struct nfa *o)
+{
+	struct nfa_node *p;
+	size_t size;
+
+	if (o->count == o->size) {
+		size = o->size == 0 ? 64 : o->size * 2;
+
+		if ((p = realloc (o->node, sizeof (p[0]) * size)) == NULL)
+			return NFA_NONE;
+
+		o->node = p;
+		o->size = size;
+	}
+
+	p = o->node + o->count;
+	p->on     = NULL;
+	p->next   = NFA_NONE;
+	p->eps[0] = NFA_NONE;
+	p->eps[1] = NFA_NONE;
+	p->token  = 0;
+	return o->count++;
+}
+
+static void nfa_eps (struct nfa *o, size_t from, size_t a, size_t b)
+{
+	o->node[from].eps[0] = a;
+	o->node[from].eps[1] = b;
+}
+
+/*
+ * Builds NFA of expression from the node without transitions, returns
+ * the final node without transitions or NFA_NONE on error
+ */
+static size_t nfa_build (struct nfa *o, const struct lexer_re *re, size_t in)
+{
+	size_t a, b, out, end;
+
+	if (in == NFA_NONE)
+		return NFA_NONE;
+
+	switch (re->kind) {
+	case LEXER_RE_SET:
+		if ((out = nfa_add (o)) != NFA_NONE) {
+			o->node[in].on   = re;
+			o->node[in].next = out;
+		}
+
+		return out;
+	case LEXER_RE_CAT:
+		return nfa_build (o, re->b, nfa_build (o, re->a, in));
+	case LEXER_RE_ALT:
+		if ((a = nfa_add (o)) == NFA_NONE ||
+		    (b = nfa_add (o)) == NFA_NONE)
+			return NFA_NONE;
+
+		nfa_eps (o, in, a, b);
+
+		if ((a = nfa_build (o, re->a, a)) == NFA_NONE ||
+		    (b = nfa_build (o, re->b, b)) == NFA_NONE ||
+		    (out = nfa_add (o)) == NFA_NONE)
+			return NFA_NONE;
+
+		nfa_eps (o, a, out, NFA_NONE);
+		nfa_eps (o, b, out, NFA_NONE);
+		return out;
+	default:
+		if ((a = nfa_add (o)) == NFA_NONE ||
+		    (out = nfa_add (o)) == NFA_NONE)
+			return NFA_NONE;
+
+		nfa_eps (o, in, a, re->kind == LEXER_RE_PLUS ? NFA_NONE : out);
+
+		if ((end = nfa_build (o, re->a, a)) == NFA_NONE)
+			return NFA_NONE;
+
+		nfa_eps (o, end, out, re->kind == LEXER_RE_OPT ? NFA_NONE : a);
+		return out;
+	}
+}
+
+/* builds NFA of all rules of specification, start node is zero */
+static int nfa_init (struct nfa *o, const struct lexer_spec *spec)
+{
+	size_t i, in, link, next, end;
+
+	o->node  = NULL;
+	o->count = 0;
+	o->size  = 0;
+
+	if ((link = nfa_add (o)) == NFA_NONE)
+		return 0;
+
+	for (i = 0; i < spec->rules.count; ++i) {
+		if ((in = nfa_add (o)) == NFA_NONE)
+			return 0;
+
+		o->node[link].eps[0] = in;
+
+		if (i + 1 < spec->rules.count) {
+			if ((next = nfa_add (o)) == NFA_NONE)
+				return 0;
+
+			o->node[link].eps[1] = next;
+			link = next;
+		}
+
+		if ((end = nfa_build (o, lexer_spec_rule (spec, i)->re,
+				      in)) == NFA_NONE)
+			return 0;
+
+		o->node[end].token = i + 1;
+	}
+
+	return 1;
+}
+
+static void nfa_fini (struct nfa *o)
+{
+	free (o->node);
+}
+
+/* o = ε-closure of o, stack should hold a node per NFA node */
+static int nfa_closure (const struct nfa *o, struct bitset *set, size_t *stack)
+{
+	size_t n = 0, i, j, x;
+
+	bitset_foreach (i, set)
+		stack[n++] = i;
+
+	while (n > 0)
+		for (i = stack[--n], j = 0; j < 2; ++j)
+			if ((x = o->node[i].eps[j]) != NFA_NONE &&
+			    !bitset_is_member (set, x)) {
+				if (!bitset_add (set, x))
+					return 0;
+
+				stack[n++] = x;
+			}
+
+	return 1;
+}
+
+/*
+ * Splits bytes into classes of bytes equivalent for all transitions,
+ * NUL byte forms class of its own
+ */
+static void dfa_classes (struct lexer_dfa *o, const struct nfa *nfa)
+{
+	size_t map[256][2], i, c, count, *p;
+	const struct lexer_re *on;
+
+	memset (o->class, 1, sizeof (o->class));
+	o->class[0] = 0;
+	o->nclasses = 2;
+
+	for (i = 0; i < nfa->count; ++i) {
+		if ((on = nfa->node[i].on) == NULL)
+			continue;
+
+		memset (map, 0xff, sizeof (map));
+		map[0][0] = 0;
+
+		for (c = 1, count = 1; c < 256; ++c) {
+			p = &map[o->class[c]][lexer_re_has (on, c)];
+
+			if (*p == SIZE_MAX)
+				*p = count++;
+
+			o->class[c] = *p;
+		}
+
+		o->nclasses = count;
+	}
+}
+
+/*
+ * Subset construction: DFA state is a set of NFA nodes
+ */
+struct subset {
+	struct bitset set;  /* the first member: hashed as bitset */
+	size_t index;
+};
+
+static void subset_free (void *o)
+{
+	struct subset *s = o;
+
+	bitset_fini (&s->set);
+	free (s);
+}
+
+static const struct data_type subset_type = {
+	.free	= subset_free,
+	.eq	= bitset_eq,
+	.hash	= bitset_hash,
+};
+
+struct build {
+	const struct nfa *nfa;
+	struct ht subsets;
+	struct da subset;     /* subsets by index */
+	size_t *stack;
+	unsigned char rep[256];  /* byte of class */
+};
+
+/* returns index of the subset, takes ownership of the set */
+static size_t build_add (struct build *o, struct lexer_dfa *dfa,
+			 struct bitset *set)
+{
+	struct subset *s, *old;
+	size_t *next, *accept, i, token = 0;
+
+	if ((old = ht_lookup (&o->subsets, set)) != NULL) {
+		bitset_fini (set);
+		return old->index;
+	}
+
+	if ((s = malloc (sizeof (*s))) == NULL)
+		goto no_subset;
+
+	s->set = *set;
+	s->index = o->subset.count;
+
+	bitset_foreach (i, &s->set)
+		if (o->nfa->node[i].token != 0 &&
+		    (token == 0 || o->nfa->node[i].token < token))
+			token = o->nfa->node[i].token;
+
+	next = realloc (dfa->next, sizeof (next[0]) * dfa->nclasses *
+				   (s->index + 1));
+	if (next == NULL)
+		goto no_next;
+
+	dfa->next = next;
+
+	if ((accept = realloc (dfa->accept, sizeof (accept[0]) *
+					    (s->index + 1))) == NULL)
+		goto no_next;
+
+	dfa->accept = accept;
+	accept[s->index] = token;
+
+	if (!da_insert (&o->subset, s))
+		goto no_next;
+
+	if (!ht_insert (&o->subsets, s)) {
+		--o->subset.count;
+		goto no_next;
+	}
+
+	return s->index;
+no_next:
+	free (s);
+no_subset:
+	bitset_fini (set);
+	return SIZE_MAX;
+}
+
+static int build_next (struct build *o, struct lexer_dfa *dfa, size_t index)
+{
+	const struct subset *s = o->subset.table[index];
+	struct bitset move;
+	size_t c, i, to;
+	const struct nfa_node *n;
+
+	dfa->next[index * dfa->nclasses] = 0;  /* end of input */
+
+	for (c = 1; c < dfa->nclasses; ++c) {
+		bitset_init (&move);
+
+		bitset_foreach (i, &s->set) {
+			n = o->nfa->node + i;
+
+			if (n->on != NULL && lexer_re_has (n->on, o->rep[c]) &&
+			    !bitset_add (&move, n->next))
+				goto error;
+		}
+
+		if (!nfa_closure (o->nfa, &move, o->stack))
+			goto error;
+
+		if ((to = build_add (o, dfa, &move)) == SIZE_MAX)
+			return 0;
+
+		dfa->next[index * dfa->nclasses + c] = to;
+	}
+
+	return 1;
+error:
+	bitset_fini (&move);
+	return 0;
+}
+
+static int dfa_build (struct lexer_dfa *o, const struct nfa *nfa)
+{
+	struct build b = { nfa };
+	struct bitset set;
+	size_t i;
+	int ok = 0;
+
+	for (i = 255; i > 0; --i)
+		b.rep[o->class[i]] = i;
+
+	if ((b.stack = malloc (sizeof (b.stack[0]) * nfa->count)) == NULL)
+		return 0;
+
+	if (!ht_init (&b.subsets, &subset_type))
+		goto no_subsets;
+
+	if (!da_init (&b.subset, NULL))
+		goto no_subset;
+
+	bitset_init (&set);  /* dead state */
+
+	if (build_add (&b, o, &set) == SIZE_MAX)
+		goto error;
+
+	bitset_init (&set);
+
+	if (!bitset_add (&set, 0) || !nfa_closure (nfa, &set, b.stack)) {
+		bitset_fini (&set);
+		goto error;
+	}
+
+	if (build_add (&b, o, &set) == SIZE_MAX)
+		goto error;
+
+	for (i = 0; i < b.subset.count; ++i)
+		if (!build_next (&b, o, i))
+			goto error;
+
+	o->nstates = b.subset.count;
+	ok = 1;
+error:
+	da_fini (&b.subset);
+	ht_fini (&b.subsets);
+no_subset:
+	free (b.stack);
+	return ok;
+no_subsets:
+	free (b.stack);
+	return 0;
+}
+
+/*
+ * Minimization by Moore's partition refinement: states of a block have
+ * equal blocks of their successors. Row of state is its key length,
+ * new block and the key: block of state and blocks of its successors.
+ */
+static int row_eq (const void *a, const void *b)
+{
+	const size_t *p = a, *q = b;
+
+	return p[0] == q[0] &&
+	       memcmp (p + 2, q + 2, sizeof (p[0]) * p[0]) == 0;
+}
+
+static size_t row_hash (const void *o)
+{
+	const size_t *p = o;
+
+	return hash (hash_seed, p + 2, sizeof (p[0]) * p[0]);
+}
+
+static const struct data_type row_type = {
+	.eq	= row_eq,
+	.hash	= row_hash,
+};
+
+/* refines partition, returns new number of blocks or zero on error */
+static size_t dfa_refine (const struct lexer_dfa *o, size_t *block,
+			  size_t *rows)
+{
+	const size_t k = o->nclasses, len = k + 3;
+	struct ht ht;
+	size_t s, c, count = 0, *row, *old;
+
+	if (!ht_init (&ht, &row_type))
+		return 0;
+
+	for (s = 0; s < o->nstates; ++s) {
+		row = rows + s * len;
+		row[0] = k + 1;
+		row[2] = block[s];
+
+		for (c = 0; c < k; ++c)
+			row[3 + c] = block[o->next[s * k + c]];
+
+		if ((old = ht_lookup (&ht, row)) != NULL) {
+			row[1] = old[1];
+			continue;
+		}
+
+		row[1] = count++;
+
+		if (!ht_insert (&ht, row)) {
+			ht_fini (&ht);
+			return 0;
+		}
+	}
+
+	for (s = 0; s < o->nstates; ++s)
+		block[s] = rows[s * len + 1];
+
+	ht_fini (&ht);
+	return count;
+}
+
+/*
+ * Replaces automaton by quotient one, states are numbered in order of
+ * breadth-first traversal from the start state
+ */
+static int dfa_merge (struct lexer_dfa *o, const size_t *block, size_t count)
+{
+	const size_t k = o->nclasses;
+	size_t *number, *state, *next, *accept, i, n, c, b;
+
+	number = malloc (sizeof (number[0]) * count);
+	state  = malloc (sizeof (state[0])  * count);
+	next   = malloc (sizeof (next[0])   * count * k);
+	accept = malloc (sizeof (accept[0]) * count);
+
+	if (number == NULL || state == NULL || next == NULL || accept == NULL)
+		goto error;
+
+	for (i = 0; i < count; ++i)
+		number[i] = SIZE_MAX;
+
+	number[block[0]] = 0, state[0] = 0;
+	number[block[1]] = 1, state[1] = 1;
+
+	for (i = 0, n = 2; i < n; ++i)
+		for (c = 0; c < k; ++c) {
+			b = block[o->next[state[i] * k + c]];
+
+			if (number[b] == SIZE_MAX) {
+				number[b] = n;
+				state[n++] = o->next[state[i] * k + c];
+			}
+
+			next[i * k + c] = number[b];
+		}
+
+	for (i = 0; i < n; ++i)
+		accept[i] = o->accept[state[i]];
+
+	free (o->next);
+	free (o->accept);
+
+	o->next    = next;
+	o->accept  = accept;
+	o->nstates = n;
+
+	free (state);
+	free (number);
+	return 1;
+error:
+	free (accept);
+	free (next);
+	free (state);
+	free (number);
+	return 0;
+}
+
+static int dfa_minimize (struct lexer_dfa *o)
+{
+	size_t *block, *rows, *accept, i, count, old = 0;
+	int ok = 0;
+
+	block  = malloc (sizeof (block[0])  * o->nstates);
+	rows   = malloc (sizeof (rows[0])   * o->nstates * (o->nclasses + 3));
+	accept = calloc (o->spec->rules.count + 1, sizeof (accept[0]));
+
+	if (block == NULL || rows == NULL || accept == NULL)
+		goto error;
+
+	/* dead state, then blocks by accepted token: accept maps to block */
+	block[0] = 0;
+
+	for (count = 1, i = 1; i < o->nstates; ++i) {
+		if (accept[o->accept[i]] == 0)
+			accept[o->accept[i]] = count++;
+
+		block[i] = accept[o->accept[i]];
+	}
+
+	while (count != old)
+		if ((old = count, count = dfa_refine (o, block, rows)) == 0)
+			goto error;
+
+	ok = dfa_merge (o, block, count);
+error:
+	free (accept);
+	free (rows);
+	free (block);
+	return ok;
+}
+
+int lexer_dfa_init (struct lexer_dfa *o, const struct lexer_spec *spec)
+{
+	struct nfa nfa;
+
+	o->spec    = spec;
+	o->nstates = 0;
+	o->next    = NULL;
+	o->accept  = NULL;
+
+	if (!nfa_init (&nfa, spec))
+		goto error;
+
+	dfa_classes (o, &nfa);
+
+	if (!dfa_build (o, &nfa) || !dfa_minimize (o))
+		goto error;
+
+	nfa_fini (&nfa);
+	return 1;
+error:
+	nfa_fini (&nfa);
+	lexer_dfa_fini (o);
+	return 0;
+}
+
+void lexer_dfa_fini (struct lexer_dfa *o)
+{
+	free (o->next);
+	free (o->accept);
+}
@@ -0,0 +1,500 @@
+/*
+ * Lexical Scanner Specification
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <lexer/spec.h>
+
+int lexer_spec_init (struct lexer_spec *o)
+{
+	arena_init (&o->arena);
+
+	if (!da_init (&o->rules, NULL)) {
+		arena_fini (&o->arena);
+		return 0;
+	}
+
+	o->extra   = NULL;
+	o->type    = NULL;
+	o->context = NULL;
+	o->line    = 0;
+	return 1;
+}
+
+void lexer_spec_fini (struct lexer_spec *o)
+{
+	da_fini (&o->rules);
+	arena_fini (&o->arena);
+}
+
+struct parser {
+	struct lexer_spec *spec;
+	const char *p;
+	size_t line;
+};
+
+static int syntax_error (struct parser *o)
+{
+	o->spec->line = o->line;
+	errno = EINVAL;
+	return 0;
+}
+
+static int is_blank (int c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*
+ * Skips blanks, comments and line breaks. Inside rule stops at the line
+ * break before a line which starts with non-blank: it ends the rule.
+ */
+static void skip (struct parser *o, int rule)
+{
+	for (;;)
+		if (is_blank (*o->p))
+			++o->p;
+		else if (*o->p == '#')
+			for (; *o->p != '\0' && *o->p != '\n'; ++o->p) {}
+		else if (*o->p == '\n') {
+			if (rule && o->p[1] != '\0' && !is_blank (o->p[1]) &&
+			    o->p[1] != '\n' && o->p[1] != '#')
+				return;
+
+			++o->p;
+			++o->line;
+		}
+		else
+			return;
+}
+
+static char *take (struct parser *o, const char *s, size_t len)
+{
+	char *p;
+
+	if ((p = arena_alloc (&o->spec->arena, len + 1)) == NULL)
+		return NULL;
+
+	memcpy (p, s, len);
+	p[len] = '\0';
+	return p;
+}
+
+/* moves to the closing quote of C string or character literal */
+static int skip_literal (struct parser *o)
+{
+	const char quote = *o->p;
+
+	for (++o->p; *o->p != quote; ++o->p)
+		if (*o->p == '\0' || *o->p == '\n')
+			return 0;
+		else if (*o->p == '\\' && o->p[1] != '\0' && *++o->p == '\n')
+			++o->line;  /* line splice */
+
+	return 1;
+}
+
+/* moves to the last character of C comment, newline is not taken */
+static int skip_comment (struct parser *o)
+{
+	if (o->p[1] == '/') {
+		for (; o->p[1] != '\0' && o->p[1] != '\n'; ++o->p) {}
+
+		return 1;
+	}
+
+	for (o->p += 2; o->p[0] != '*' || o->p[1] != '/'; ++o->p)
+		if (*o->p == '\0')
+			return 0;
+		else if (*o->p == '\n')
+			++o->line;
+
+	++o->p;
+	return 1;
+}
+
+/*
+ * Returns code in braces without surrounding blanks. Braces inside of
+ * literals and comments are not counted.
+ */
+static char *get_code (struct parser *o)
+{
+	const char *start = o->p + 1;
+	size_t level, len;
+
+	if (*o->p != '{')
+		goto error;
+
+	for (level = 0; ; ++o->p)
+		if (*o->p == '\0')
+			goto error;
+		else if (*o->p == '\n')
+			++o->line;
+		else if (*o->p == '\'' || *o->p == '"') {
+			if (!skip_literal (o))
+				goto error;
+		}
+		else if (*o->p == '/' && (o->p[1] == '*' || o->p[1] == '/')) {
+			if (!skip_comment (o))
+				goto error;
+		}
+		else if (*o->p == '{')
+			++level;
+		else if (*o->p == '}' && --level == 0)
+			break;
+
+	for (; is_blank (*start) || *start == '\n'; ++start) {}
+
+	for (len = o->p - start; len > 0 && (is_blank (start[len - 1]) ||
+					     start[len - 1] == '\n'); --len) {}
+
+	++o->p;
+	return take (o, start, len);
+error:
+	syntax_error (o);
+	return NULL;
+}
+
+static int is_name (int c)
+{
+	return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+	       (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+static char *get_name (struct parser *o)
+{
+	const char *start = o->p;
+
+	for (; is_name (*o->p); ++o->p) {}
+
+	if (o->p == start) {
+		syntax_error (o);
+		return NULL;
+	}
+
+	return take (o, start, o->p - start);
+}
+
+static int get_hex (int c)
+{
+	return c >= '0' && c <= '9' ? c - '0' :
+	       c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+	       c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+/* returns the next possibly escaped byte, or -1 on error */
+static int get_char (struct parser *o)
+{
+	int c = (unsigned char) *o->p, h, l;
+
+	if (c == '\0' || c == '\n')
+		return -1;
+
+	++o->p;
+
+	if (c != '\\')
+		return c;
+
+	switch (c = (unsigned char) *o->p++) {
+	case 'n':	return '\n';
+	case 't':	return '\t';
+	case 'r':	return '\r';
+	case 'x':
+		if ((h = get_hex (o->p[0])) < 0 || (l = get_hex (o->p[1])) < 0)
+			return -1;
+
+		o->p += 2;
+		return h * 16 + l > 0 ? h * 16 + l : -1;
+	case '\0':
+	case '\n':
+		return -1;
+	}
+
+	return c;
+}
+
+static struct lexer_re *re_alloc (struct parser *o, enum lexer_re_kind kind,
+				  struct lexer_re *a, struct lexer_re *b)
+{
+	struct lexer_re *re;
+
+	if ((re = arena_alloc (&o->spec->arena, sizeof (*re))) == NULL)
+		return NULL;
+
+	re->kind = kind;
+	re->a = a;
+	re->b = b;
+	memset (re->set, 0, sizeof (re->set));
+	return re;
+}
+
+static void set_add (struct lexer_re *o, unsigned from, unsigned to)
+{
+	for (; from <= to; ++from)
+		o->set[from / 8] |= 1 << (from % 8);
+}
+
+static struct lexer_re *get_string (struct parser *o)
+{
+	const char quote = *o->p++;
+	struct lexer_re *re = NULL, *c;
+	int x;
+
+	while (*o->p != quote) {
+		if ((x = get_char (o)) < 0)
+			goto error;
+
+		if ((c = re_alloc (o, LEXER_RE_SET, NULL, NULL)) == NULL)
+			return NULL;
+
+		set_add (c, x, x);
+
+		if (re != NULL &&
+		    (c = re_alloc (o, LEXER_RE_CAT, re, c)) == NULL)
+			return NULL;
+
+		re = c;
+	}
+
+	++o->p;
+
+	if (re != NULL)
+		return re;
+error:
+	syntax_error (o);
+	return NULL;
+}
+
+static struct lexer_re *get_class (struct parser *o)
+{
+	struct lexer_re *re;
+	int neg, from, to;
+	size_t i;
+
+	if ((re = re_alloc (o, LEXER_RE_SET, NULL, NULL)) == NULL)
+		return NULL;
+
+	++o->p;
+
+	if ((neg = *o->p == '^'))
+		++o->p;
+
+	while (*o->p != ']') {
+		if ((from = to = get_char (o)) < 0)
+			goto error;
+
+		if (o->p[0] == '-' && o->p[1] != ']') {
+			++o->p;
+
+			if ((to = get_char (o)) < from)
+				goto error;
+		}
+
+		set_add (re, from, to);
+	}
+
+	++o->p;
+
+	if (neg) {
+		for (i = 0; i < sizeof (re->set); ++i)
+			re->set[i] = ~re->set[i];
+
+		re->set[0] &= ~1;  /* end of input */
+	}
+
+	return re;
+error:
+	syntax_error (o);
+	return NULL;
+}
+
+static struct lexer_re *get_alt (struct parser *o);
+
+static struct lexer_re *get_atom (struct parser *o)
+{
+	struct lexer_re *re;
+
+	switch (*o->p) {
+	case '\'':
+	case '"':
+		return get_string (o);
+	case '[':
+		return get_class (o);
+	case '.':
+		if ((re = re_alloc (o, LEXER_RE_SET, NULL, NULL)) == NULL)
+			return NULL;
+
+		++o->p;
+		set_add (re, 1, 255);
+		re->set['\n' / 8] &= ~(1 << ('\n' % 8));
+		return re;
+	case '(':
+		++o->p;
+
+		if ((re = get_alt (o)) == NULL)
+			return NULL;
+
+		skip (o, 1);
+
+		if (*o->p != ')')
+			break;
+
+		++o->p;
+		return re;
+	}
+
+	syntax_error (o);
+	return NULL;
+}
+
+static struct lexer_re *get_post (struct parser *o)
+{
+	struct lexer_re *re;
+	enum lexer_re_kind kind;
+
+	if ((re = get_atom (o)) == NULL)
+		return NULL;
+
+	for (;; ++o->p) {
+		if (*o->p == '*')
+			kind = LEXER_RE_STAR;
+		else if (*o->p == '+')
+			kind = LEXER_RE_PLUS;
+		else if (*o->p == '?')
+			kind = LEXER_RE_OPT;
+		else
+			return re;
+
+		if ((re = re_alloc (o, kind, re, NULL)) == NULL)
+			return NULL;
+	}
+}
+
+static int is_atom (int c)
+{
+	return c == '\'' || c == '"' || c == '[' || c == '.' || c == '(';
+}
+
+static struct lexer_re *get_cat (struct parser *o)
+{
+	struct lexer_re *re, *next;
+
+	if ((re = get_post (o)) == NULL)
+		return NULL;
+
+	for (skip (o, 1); is_atom (*o->p); skip (o, 1))
+		if ((next = get_post (o)) == NULL ||
+		    (re = re_alloc (o, LEXER_RE_CAT, re, next)) == NULL)
+			return NULL;
+
+	return re;
+}
+
+static struct lexer_re *get_alt (struct parser *o)
+{
+	struct lexer_re *re, *next;
+
+	if ((re = get_cat (o)) == NULL)
+		return NULL;
+
+	while (*o->p == '|') {
+		++o->p;
+		skip (o, 1);
+
+		if ((next = get_cat (o)) == NULL ||
+		    (re = re_alloc (o, LEXER_RE_ALT, re, next)) == NULL)
+			return NULL;
+	}
+
+	return re;
+}
+
+static int get_directive (struct parser *o)
+{
+	struct lexer_spec *s = o->spec;
+	const char *name = o->p;
+	const char **target;
+	size_t len;
+
+	for (; is_name (*o->p); ++o->p) {}
+
+	len = o->p - name;
+
+	if (len == 5 && strncmp (name, "extra", len) == 0)
+		target = &s->extra;
+	else if (len == 4 && strncmp (name, "type", len) == 0)
+		target = &s->type;
+	else if (len == 7 && strncmp (name, "context", len) == 0)
+		target = &s->context;
+	else
+		return syntax_error (o);
+
+	skip (o, 0);
+	return (*target = get_code (o)) != NULL;
+}
+
+static int get_rule (struct parser *o)
+{
+	struct lexer_rule *r;
+
+	if ((r = arena_alloc (&o->spec->arena, sizeof (*r))) == NULL ||
+	    (r->name = get_name (o)) == NULL)
+		return 0;
+
+	if ((r->ignore = *o->p == '*'))
+		++o->p;
+
+	r->action = NULL;
+	skip (o, 1);
+
+	if (*o->p != ':')
+		return syntax_error (o);
+
+	++o->p;
+	skip (o, 1);
+
+	if ((r->re = get_alt (o)) == NULL)
+		return 0;
+
+	if (*o->p == '{') {
+		if ((r->action = get_code (o)) == NULL)
+			return 0;
+
+		skip (o, 1);
+	}
+
+	if (*o->p == ';')
+		++o->p;
+	else if (*o->p != '\n' && *o->p != '\0')
+		return syntax_error (o);
+
+	return da_insert (&o->spec->rules, r);
+}
+
+int lexer_spec_parse (struct lexer_spec *o, const char *text)
+{
+	struct parser p = { o, text, 1 };
+
+	for (skip (&p, 0); *p.p != '\0'; skip (&p, 0)) {
+		if (*p.p == '%') {
+			++p.p;
+			skip (&p, 0);
+
+			if (!get_directive (&p))
+				return 0;
+		}
+		else if (!get_rule (&p))
+			return 0;
+	}
+
+	if (o->rules.count == 0)
+		return syntax_error (&p);
+
+	return 1;
+}
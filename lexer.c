@@ -6,31 +6,140 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <stdint.h>
 #include <string.h>
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "lexer.h"
 
 void lexer_buf_init (struct lexer_buf *o, const lexer_input_t *buf)
 {
 	o->start = o->stop = buf;
+	o->more = 0;
+}
+
+/*
+ * The skip_space function returns pointer to the first byte after run
+ * of blanks, the skip_line function returns pointer to the end of line
+ * or to the terminating NUL.
+ *
+ * Vector versions read whole aligned groups of bytes and thus may read
+ * past the terminating NUL, but never cross a page boundary after it.
+ */
+#if defined (__AVX2__) || defined (__SSE2__)
+
+#if defined (__AVX2__)
+#define GROUP  32
+#define ALL    0xffffffffu
+
+typedef __m256i group;
+
+#define group_load(p)	_mm256_load_si256 ((const void *) (p))
+#define group_eq(g, c)	_mm256_cmpeq_epi8 ((g), _mm256_set1_epi8 (c))
+#define group_or(a, b)	_mm256_or_si256 ((a), (b))
+#define group_mask(g)	((unsigned) _mm256_movemask_epi8 (g))
+#else
+#define GROUP  16
+#define ALL    0xffffu
+
+typedef __m128i group;
+
+#define group_load(p)	_mm_load_si128 ((const void *) (p))
+#define group_eq(g, c)	_mm_cmpeq_epi8 ((g), _mm_set1_epi8 (c))
+#define group_or(a, b)	_mm_or_si128 ((a), (b))
+#define group_mask(g)	((unsigned) _mm_movemask_epi8 (g))
+#endif
+
+/* returns bit mask of non-blank bytes of the group */
+__attribute__ ((no_sanitize_address))
+static unsigned space_stop (const char *p)
+{
+	const group g = group_load (p);
+
+	return ALL ^ group_mask (group_or (group_or (group_eq (g, ' '),
+						     group_eq (g, '\t')),
+					   group_eq (g, '\n')));
+}
+
+/* returns bit mask of newlines and NULs of the group */
+__attribute__ ((no_sanitize_address))
+static unsigned line_stop (const char *p)
+{
+	const group g = group_load (p);
+
+	return group_mask (group_or (group_eq (g, '\n'), group_eq (g, '\0')));
+}
+
+static const char *skip_space (const char *p)
+{
+	const char *q = (const void *) ((uintptr_t) p & -(uintptr_t) GROUP);
+	unsigned stop = space_stop (q) >> (p - q);
+
+	if (stop != 0)
+		return p + __builtin_ctz (stop);
+
+	while ((stop = space_stop (q += GROUP)) == 0) {}
+
+	return q + __builtin_ctz (stop);
 }
 
+static const char *skip_line (const char *p)
+{
+	const char *q = (const void *) ((uintptr_t) p & -(uintptr_t) GROUP);
+	unsigned stop = line_stop (q) >> (p - q);
+
+	if (stop != 0)
+		return p + __builtin_ctz (stop);
+
+	while ((stop = line_stop (q += GROUP)) == 0) {}
+
+	return q + __builtin_ctz (stop);
+}
+
+#else
+
+static const char *skip_space (const char *p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\n')
+		++p;
+
+	return p;
+}
+
+static const char *skip_line (const char *p)
+{
+	while (*p != '\0' && *p != '\n')
+		++p;
+
+	return p;
+}
+
+#endif
+
+/*
+ * Token ended by NUL could continue in more input: the scanner returns
+ * zero before its action is run, o->start points to the token to scan
+ * again after refill.
+ */
 #define HEAD		(*o->stop)
+#define MORE		do { if (HEAD == 0 && o->more) return 0; } while (0)
 #define GOT(token)	do { return LEXER_ ## token;	} while (0)
-#define IGNORE		do { goto start;		} while (0)
+#define IGNORE		do { if (HEAD == 0) return 0; goto start; } while (0)
 #define NEXT		do { ++o->stop;			} while (0)
 #define GOTO(label)	do { NEXT; goto x_ ## label;	} while (0)
 
-#define DEFINE_DATA							\
-	const size_t len = o->stop - o->start;				\
-	lexer_input_t data[len + 1];					\
-									\
-	memcpy (data, o->start, len * sizeof (lexer_input_t));		\
-	data[len] = 0
+#define ALNUM	((HEAD >= 'A' && HEAD <= 'Z') || \
+		 (HEAD >= 'a' && HEAD <= 'z') || (HEAD >= '0' && HEAD <= '9'))
 
 int lexer_buf_process (struct lexer_buf *o, union lexer_type *value)
 {
-	o->start = o->stop;
 start:
+	o->start = o->stop;
 	if (HEAD == 0)
 		return 0;
 
@@ -54,24 +163,29 @@ start:
 
 	return -1;
 x_comment_1:
-	if (HEAD != 0 && HEAD != '\n')
-		GOTO (comment_1);
-
+	o->stop = skip_line (o->stop);
 	IGNORE;
 x_space_1:
-	if (HEAD == ' ' || HEAD == '\t' || HEAD == '\n')
-		GOTO (space_1);
-
+	o->stop = skip_space (o->stop);
 	IGNORE;
 x_id_1:
 	if (HEAD == '-')
-		NEXT;
+		GOTO (id_2);
+
+	if (ALNUM)
+		GOTO (id_1);
 
-	if ((HEAD >= 'A' && HEAD <= 'Z') || (HEAD >= 'a' && HEAD <= 'z') ||
-	    (HEAD >= '0' && HEAD <= '9'))
+	MORE;
+	goto t_id;
+x_id_2:
+	if (ALNUM)
 		GOTO (id_1);
 
-	{ DEFINE_DATA; value->symbol = grammar_add (o->grammar, data); }
+	MORE;
+	--o->stop;  /* dash not followed by alphanumeric is not taken */
+t_id:
+	value->symbol = grammar_add_slice (o->grammar, o->start,
+					   o->stop - o->start);
 
 	GOT (ID);
 x_is_1:
@@ -84,19 +198,27 @@ x_term_1:
 
 #ifndef NOGENERIC
 
-#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
 
-static const size_t count = BUFSIZ / sizeof (lexer_input_t);
+#ifndef NOFILE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 int lexer_init (struct lexer *o, void *cookie, lexer_read_fn *read)
 {
-	if ((o->buf = malloc (count * sizeof (o->buf[0]))) == NULL)
+	o->chunk = LEXER_CHUNK;
+	o->size  = o->chunk + 1;
+
+	if ((o->buf = malloc (o->size * sizeof (o->buf[0]))) == NULL)
 		return 0;
 
 	o->len = 0;
 	o->buf[o->len] = '\0';
 	lexer_buf_init (&o->lexer_buf, o->buf);
+	o->lexer_buf.more = 1;
 
 	o->cookie = cookie;
 	o->read = read;
@@ -106,32 +228,80 @@ int lexer_init (struct lexer *o, void *cookie, lexer_read_fn *read)
 
 void lexer_fini (struct lexer *o)
 {
+#ifndef NOFILE
+	if (o->read == NULL) {  /* mapped file */
+		munmap (o->buf, (o->len + 1) * sizeof (o->buf[0]));
+		return;
+	}
+#endif
 	free (o->buf);
 }
 
-int lexer_process (struct lexer *o, union lexer_type *value)
+/*
+ * Drops processed data and makes room for chunk items: the buffer grows
+ * geometrically when the pending token fills it.
+ */
+static int reserve (struct lexer *o)
 {
-	int token;
-	size_t len;
+	lexer_input_t *buf;
+	size_t size;
 
-	token = lexer_buf_process (&o->lexer_buf, value);
+	o->len = (o->buf + o->len) - o->lexer_buf.start;
+	memmove (o->buf, o->lexer_buf.start, o->len * sizeof (o->buf[0]));
 
-	if (token > 0)
-		return token;
+	if (o->size - o->len > o->chunk)
+		return 1;
 
-	/* drop processed data */
-	o->len = (o->buf + o->len) - o->lexer_buf.start;
-	memmove (o->buf, o->lexer_buf.start, o->len);
+	if ((size = o->len + o->chunk + 1) < o->size * 2)
+		size = o->size * 2;
 
-	len = o->read (o->buf + o->len, count - 1 - o->len, o->cookie);
-	if (len <= 0)
-		return len;
+	if (size >= SIZE_MAX / sizeof (o->buf[0])) {
+		errno = ENOMEM;
+		return 0;
+	}
+
+	if ((buf = realloc (o->buf, size * sizeof (o->buf[0]))) == NULL)
+		return 0;
+
+	o->buf  = buf;
+	o->size = size;
+	return 1;
+}
+
+/* returns number of items read, zero at end of input or -1 on error */
+static int refill (struct lexer *o)
+{
+	size_t count;
+	int len;
+
+	if (!reserve (o))
+		return -1;
+
+	count = o->chunk < INT_MAX ? o->chunk : INT_MAX;
+	len = o->read (o->buf + o->len, count, o->cookie);
+	if (len > 0)
+		o->len += len;
 
-	o->len += len;
 	o->buf[o->len] = '\0';
 	lexer_buf_init (&o->lexer_buf, o->buf);
+	o->lexer_buf.more = len > 0;
+
+	return len;
+}
+
+int lexer_process (struct lexer *o, union lexer_type *value)
+{
+	int token, len;
+
+	for (;;) {
+		token = lexer_buf_process (&o->lexer_buf, value);
+
+		if (token != 0 || !o->lexer_buf.more)
+			return token;
 
-	return lexer_buf_process (&o->lexer_buf, value);
+		if ((len = refill (o)) < 0)
+			return len;
+	}
 }
 
 #ifndef NOFILE
@@ -152,5 +322,49 @@ int lexer_file_init (struct lexer *o, FILE *f)
 	return lexer_init (o, f, file_read);
 }
 
+/*
+ * The file is mapped over anonymous zero-filled mapping one byte longer
+ * than the file, thus the NUL sentinel follows the file contents even
+ * if its size is a multiple of page size.
+ */
+int lexer_mmap_init (struct lexer *o, FILE *f)
+{
+	struct stat st;
+	void *map;
+
+	if (fstat (fileno (f), &st) != 0)
+		return 0;
+
+	if (!S_ISREG (st.st_mode))
+		return lexer_file_init (o, f);
+
+	if (st.st_size >= SIZE_MAX / sizeof (o->buf[0])) {
+		errno = EFBIG;
+		return 0;
+	}
+
+	o->len = st.st_size / sizeof (o->buf[0]);
+
+	map = mmap (NULL, (o->len + 1) * sizeof (o->buf[0]), PROT_READ,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+		return 0;
+
+	if (o->len > 0 &&
+	    mmap (map, o->len * sizeof (o->buf[0]), PROT_READ,
+		  MAP_PRIVATE | MAP_FIXED, fileno (f), 0) == MAP_FAILED)
+		goto no_map;
+
+	o->buf = map;
+	lexer_buf_init (&o->lexer_buf, o->buf);
+
+	o->cookie = NULL;
+	o->read = NULL;
+	return 1;
+no_map:
+	munmap (map, (o->len + 1) * sizeof (o->buf[0]));
+	return 0;
+}
+
 #endif  /* NOFILE */
 #endif  /* NOGENERIC */
@@ -20,6 +20,7 @@ union lexer_type {
 
 struct lexer_buf {
 	const lexer_input_t *start, *stop;  /* matched item */
+	int more;                           /* input continues after NUL */
 	struct grammar *grammar;
 };
 
@@ -27,7 +28,7 @@ void lexer_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
 int  lexer_buf_process (struct lexer_buf *o, union lexer_type *value);
 
 enum lexer_token {
-	LAXER_COMMENT = 1,	/* #[^\n]* */
+	LEXER_COMMENT = 1,	/* #[^\n]* */
 	LEXER_SPACE,		/* [ \t\n]+ */
 	LEXER_ID,		/* [A-Za-z](-?[A-Za-z0-9])* */
 	LEXER_IS,		/* : */
@@ -38,10 +39,19 @@ enum lexer_token {
 #ifndef NOGENERIC
 typedef int lexer_read_fn (lexer_input_t *buf, size_t count, void *cookie);
 
+/* default read size, in items */
+#define LEXER_CHUNK  65536
+
+/*
+ * Input is read by chunk items, chunk may be changed after lexer_init.
+ * Unprocessed tail of buffer is kept for the next read, the buffer grows
+ * geometrically if a token does not fit into it.
+ */
 struct lexer {
 	struct lexer_buf lexer_buf;
 	lexer_input_t *buf;
-	size_t len;
+	size_t len, size;  /* length of data and size of buffer */
+	size_t chunk;
 	void *cookie;
 	lexer_read_fn *read;
 };
@@ -55,6 +65,16 @@ int  lexer_process (struct lexer *o, union lexer_type *value);
 
 int lexer_file_init (struct lexer *o, FILE *f);
 
+/*
+ * The lexer_mmap_init function maps the whole regular file read-only
+ * and scans it in place without refills, other files are read as with
+ * lexer_file_init. The scanner stops at NUL byte, the one after the end
+ * of file is guaranteed.
+ *
+ * Returns non-zero on success or zero on error, errno is set.
+ */
+int lexer_mmap_init (struct lexer *o, FILE *f);
+
 #endif  /* NOFILE */
 #endif  /* NOGENERIC */
 
@@ -9,31 +9,38 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <data/hash.h>
+
 #include "rule.h"
 
-static int symbol_compare (const void *a, const void *b)
+static int symbol_eq (const void *a, const void *b)
 {
 	const struct symbol *p = a, *q = b;
 
-	return strcmp (p->name, q->name);
+	return p->len == q->len && memcmp (p->name, q->name, p->len) == 0;
+}
+
+static size_t symbol_hash (const void *o)
+{
+	const struct symbol *s = o;
+
+	return hash (hash_seed, s->name, s->len);
 }
 
-static struct symbol *symbol_alloc (const char *name)
+/* allocates symbol with its name in one block */
+static struct symbol *symbol_alloc (const char *name, size_t len)
 {
 	struct symbol *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
-		goto no_symbol;
+	if ((o = malloc (sizeof (*o) + len + 1)) == NULL)
+		return NULL;
 
-	if ((o->name = strdup (name)) == NULL)
-		goto no_strdup;
+	o->name = memcpy (o + 1, name, len);
+	o->name[len] = '\0';
+	o->len = len;
 
 	rhs_seq_init (&o->seq);
 	return o;
-no_strdup:
-	free (o);
-no_symbol:
-	return NULL;
 }
 
 static void rhs_symbol_free (struct rhs_symbol *o)
@@ -60,13 +67,18 @@ static void symbol_free (void *s)
 	while ((p = rhs_seq_pop (&o->seq)) != NULL)
 		rhs_free (p);
 
-	free (o->name);
 	free (o);
 }
 
+static const struct data_type symbol_type = {
+	.free	= symbol_free,
+	.eq	= symbol_eq,
+	.hash	= symbol_hash,
+};
+
 int grammar_init (struct grammar *o)
 {
-	if ((o->set = rb_alloc (symbol_compare)) == NULL)
+	if (!ht_init (&o->set, &symbol_type))
 		return 0;
 
 	o->start = NULL;
@@ -75,11 +87,11 @@ int grammar_init (struct grammar *o)
 
 void grammar_fini (struct grammar *o)
 {
-	rb_free (o->set, symbol_free);
+	ht_fini (&o->set);
 }
 
 /*
- * The grammar_lookup function lookups symbol name in the specified
+ * The grammar_add function lookups symbol name in the specified
  * grammar.
  *
  * Returns a pointer to the symbol in grammar or NULL in case of memory
@@ -87,24 +99,37 @@ void grammar_fini (struct grammar *o)
  */
 struct symbol *grammar_add (struct grammar *o, const char *name)
 {
-	struct rb_node *n;
+	return grammar_add_slice (o, name, strlen (name));
+}
+
+/*
+ * The grammar_add_slice function lookups symbol by name of len bytes,
+ * which is not required to be NUL-terminated.
+ *
+ * Returns a pointer to the symbol in grammar or NULL in case of memory
+ * allocation error.
+ */
+struct symbol *grammar_add_slice (struct grammar *o, const char *name,
+				  size_t len)
+{
 	struct symbol fake, *s;
 
 	fake.name = (void *) name;
+	fake.len  = len;
 
-	if ((n = rb_lookup (o->set, &fake)) != NULL)
-		return rb_data (n);
+	if ((s = ht_lookup (&o->set, &fake)) != NULL)
+		return s;
 
-	if ((s = symbol_alloc (name)) == NULL)
+	if ((s = symbol_alloc (name, len)) == NULL)
 		goto no_symbol;
 
+	if (!ht_insert (&o->set, s))
+		goto no_insert;
+
 	if (o->start == NULL)
 		o->start = s;
 
-	if ((n = rb_insert (o->set, s)) == NULL)
-		goto no_insert;
-
-	return rb_data (n);
+	return s;
 no_insert:
 	symbol_free (s);
 no_symbol:
@@ -9,11 +9,11 @@
 #ifndef RULE_H
 #define RULE_H  1
 
-#include <data/rb-tree.h>
+#include <data/ht.h>
 #include <data/seq.h>
 
 struct grammar {
-	struct rb_tree *set;	/* set of symbols          */
+	struct ht set;		/* set of symbols          */
 	struct symbol *start;	/* start symbol of grammar */
 };
 
@@ -35,7 +35,8 @@ struct rhs {
 SEQ_DECLARE (rhs)
 
 struct symbol {
-	char *name;
+	char *name;		/* NUL-terminated          */
+	size_t len;		/* length of name          */
 	struct rhs_seq seq;
 };
 
@@ -53,6 +54,18 @@ static inline int symbol_is_terminal (struct symbol *o)
  */
 struct symbol *grammar_add (struct grammar *o, const char *name);
 
+/*
+ * The grammar_add_slice function lookups symbol by name of len bytes,
+ * which is not required to be NUL-terminated: scanners pass lexemes
+ * right from the input buffer. The name is copied on the first
+ * occurrence only.
+ *
+ * Returns a pointer to the symbol in grammar or NULL in case of memory
+ * allocation error.
+ */
+struct symbol *grammar_add_slice (struct grammar *o, const char *name,
+				  size_t len);
+
 /*
  * The rhs_symbol_add function allocates new RHS symbol and insert it
  * to the end of the specified RHS.
@@ -17,5 +17,5 @@ int string_eq (const void *a, const void *b)
 
 size_t string_hash (const void *o)
 {
-	return hash (0, o, strlen (o));
+	return hash_string (hash_seed, o);
 }
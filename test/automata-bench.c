@@ -0,0 +1,198 @@
+/*
+ * Automata Build Benchmark
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <parser/automata-build.h>
+#include <parser/automata-lalr.h>
+#include <parser/grammar.h>
+
+#include "grammar-gen.h"
+#include "grammar-rule.h"
+#include "grammar-sets.h"
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Measures calculation of nullable, FIRST and FOLLOW sets
+ */
+static void bench_first (const struct grammar *g)
+{
+	struct grammar_sets sets;
+	double start, time;
+
+	sets_init (&sets, g);
+	start = now ();
+
+	sets_make (&sets, g);
+
+	time = now () - start;
+	printf ("first : nullable, FIRST and FOLLOW = %.3f ms\n", time * 1e3);
+
+	sets_fini (&sets);
+}
+
+enum bench_mode {
+	BENCH_LALR,
+	BENCH_LR1,
+};
+
+/*
+ * Returns number of items taken from cached closures of non-terminals
+ * by one closure of every state, each of them would be expanded by rule
+ * walk otherwise
+ */
+static size_t closure_saved (const struct automata *a)
+{
+	const size_t base = a->grammar->nterms;
+	const struct state *st;
+	const struct item *it;
+	const struct symbol *s;
+	size_t i, j, count = 0;
+
+	for (i = 0; i < a->state.count; ++i) {
+		st = automata_state (a, i);
+
+		ht_foreach (j, it, &st->items)
+			if ((s = it->rule->prod[it->pos]) != NULL &&
+			    s->rules != NULL)
+				count += bitset_count (a->closure + s->id -
+						       base);
+	}
+
+	return count;
+}
+
+/*
+ * Builds automata in the specified mode and measures the cost of state
+ * deduplication: lookup of every known state in the state set
+ */
+static void bench_build (const struct grammar *g, unsigned flags,
+			 enum bench_mode mode, const char *name)
+{
+	struct automata a;
+	double start, build, lookup, lalr;
+	size_t i;
+	const struct state *s;
+	int ok;
+
+	if (!automata_init (&a))
+		err (1, "cannot initialize automata");
+
+	a.flags = flags;
+	start = now ();
+
+	ok = mode == BENCH_LR1 ? automata_build_lr1 (&a, g) :
+				 automata_build (&a, g);
+	if (!ok)
+		err (1, "cannot build states");
+
+	build = now () - start;
+	start = now ();
+
+	ht_foreach (i, s, &a.states)
+		if (ht_lookup (&a.states, s) != s)
+			errx (1, "cannot lookup state");
+
+	lookup = now () - start;
+
+	printf ("%-6s: states = %zu, build = %.3f ms, "
+		"lookup = %.1f ns/state\n",
+		name, a.states.count, build * 1e3,
+		lookup * 1e9 / a.states.count);
+
+	printf ("%-6s: closure joins = %zu, closure items reused = %zu\n",
+		name, a.closure_joins, closure_saved (&a));
+
+	if (mode == BENCH_LALR) {
+		start = now ();
+
+		if (!automata_lalr (&a))
+			err (1, "cannot calculate lookaheads");
+
+		lalr = now () - start;
+		printf ("%-6s: lalr = %.3f ms\n", name, lalr * 1e3);
+	}
+
+	automata_fini (&a);
+}
+
+/*
+ * Runs benchmark in a child process to report its own peak memory usage
+ */
+static void bench_run (const struct grammar *g, unsigned flags,
+		       enum bench_mode mode, const char *name)
+{
+	pid_t pid;
+	int status;
+	struct rusage ru;
+
+	fflush (stdout);
+
+	if ((pid = fork ()) < 0)
+		err (1, "cannot fork");
+
+	if (pid == 0) {
+		bench_build (g, flags, mode, name);
+		fflush (stdout);
+		_exit (0);
+	}
+
+	if (wait4 (pid, &status, 0, &ru) < 0)
+		err (1, "cannot wait for benchmark");
+
+	if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+		errx (1, "%s benchmark failed", name);
+
+	printf ("%-6s: peak memory = %ld KiB\n", name, ru.ru_maxrss);
+}
+
+int main (int argc, char *argv[])
+{
+	size_t rules = argc > 1 ? strtoul (argv[1], NULL, 0) : 10000;
+	const char *family = argc > 2 ? argv[2] : "wide";
+	struct gen gen;
+	struct grammar g;
+
+	gen_init (&gen);
+
+	if (!gen_family (&gen, family, rules))
+		errx (1, "unknown grammar family %s", family);
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, gen.rules) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	printf ("rules = %zu, items = %zu\n", g.nrules, g.nitems);
+
+	bench_first (&g);
+	bench_run (&g, 0, BENCH_LALR, "ht");
+	bench_run (&g, AUTOMATA_BITSET, BENCH_LALR, "bitset");
+	bench_run (&g, 0, BENCH_LR1, "pager");
+	bench_run (&g, AUTOMATA_CANONICAL, BENCH_LR1, "lr1");
+
+	grammar_fini (&g);
+	gen_fini (&gen);
+	return 0;
+}
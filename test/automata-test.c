@@ -13,7 +13,9 @@
 
 #include <parser/automata-code.h>
 #include <parser/automata-build.h>
+#include <parser/automata-lalr.h>
 #include <parser/automata-show.h>
+#include <parser/automata-table.h>
 #include <parser/grammar.h>
 #include <parser/grammar-show.h>
 
@@ -23,11 +25,12 @@ int main (int argc, char *argv[])
 {
 	struct grammar g;
 	struct automata a;
+	struct automata_table t;
 
 	if (!grammar_init (&g))
 		err (1, "cannot initialize grammar");
 
-	if (!load_grammar (&g, G))
+	if (!load_grammar (&g, G) || !grammar_number (&g))
 		err (1, "cannot load grammar");
 
 	grammar_show (&g, stderr);
@@ -38,9 +41,19 @@ int main (int argc, char *argv[])
 	if (!automata_build (&a, &g))
 		err (1, "cannot build states");
 
+	if (!automata_lalr (&a))
+		err (1, "cannot calculate lookaheads");
+
 	automata_show (&a, stderr);
 	automata_code (&a, stdout);
 
+	if (!automata_table_init (&t, &a))
+		err (1, "cannot build tables");
+
+	if (!automata_table_code (&t, stdout))
+		err (1, "cannot emit tables");
+	automata_table_fini (&t);
+
 	grammar_fini (&g);
 	automata_fini (&a);
 	return 0;
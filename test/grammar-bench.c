@@ -0,0 +1,161 @@
+/*
+ * Synthetic Grammar Benchmark Suite
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Usage: grammar-bench [rules [family...]]
+ *
+ * Prints tab-separated report with header line: for every grammar
+ * family time of grammar load, LR(0) automaton build, LALR lookahead
+ * calculation and code emission, sizes of grammar and automaton and
+ * peak memory usage of the run.
+ */
+
+#define _GNU_SOURCE
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <parser/automata-build.h>
+#include <parser/automata-code.h>
+#include <parser/automata-lalr.h>
+#include <parser/grammar.h>
+
+#include "grammar-gen.h"
+#include "grammar-rule.h"
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static ssize_t count_write (void *cookie, const char *buf, size_t size)
+{
+	*(size_t *) cookie += size;
+	return size;
+}
+
+/* returns stream which counts written bytes and discards them */
+static FILE *count_open (size_t *count)
+{
+	cookie_io_functions_t io = { NULL, count_write, NULL, NULL };
+
+	*count = 0;
+	return fopencookie (count, "w", io);
+}
+
+static void bench (const char *family, size_t rules)
+{
+	struct gen gen;
+	struct grammar g;
+	struct automata a;
+	FILE *f;
+	double start, load, build, lalr, emit;
+	size_t size;
+
+	gen_init (&gen);
+
+	if (!gen_family (&gen, family, rules))
+		errx (1, "unknown grammar family %s", family);
+
+	start = now ();
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, gen.rules) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	load  = now () - start;
+	start = now ();
+
+	if (!automata_init (&a))
+		err (1, "cannot initialize automata");
+
+	if (!automata_build (&a, &g))
+		err (1, "cannot build states");
+
+	build = now () - start;
+	start = now ();
+
+	if (!automata_lalr (&a))
+		err (1, "cannot calculate lookaheads");
+
+	lalr = now () - start;
+
+	if ((f = count_open (&size)) == NULL)
+		err (1, "cannot open code stream");
+
+	start = now ();
+
+	if (!automata_code (&a, f) || fclose (f) != 0)
+		err (1, "cannot emit code");
+
+	emit = now () - start;
+
+	printf ("%s\t%zu\t%zu\t%zu\t%zu\t%.3f\t%.3f\t%.3f\t%.3f\t%.1f\t%zu",
+		family, g.nrules, g.nsymbols, g.nitems, a.states.count,
+		load * 1e3, build * 1e3, lalr * 1e3, emit * 1e3,
+		build * 1e9 / a.states.count, size);
+
+	automata_fini (&a);
+	grammar_fini (&g);
+	gen_fini (&gen);
+}
+
+/*
+ * Runs benchmark in a child process to report its own peak memory usage
+ */
+static void bench_run (const char *family, size_t rules)
+{
+	pid_t pid;
+	int status;
+	struct rusage ru;
+
+	fflush (stdout);
+
+	if ((pid = fork ()) < 0)
+		err (1, "cannot fork");
+
+	if (pid == 0) {
+		bench (family, rules);
+		fflush (stdout);
+		_exit (0);
+	}
+
+	if (wait4 (pid, &status, 0, &ru) < 0)
+		err (1, "cannot wait for benchmark");
+
+	if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+		errx (1, "%s benchmark failed", family);
+
+	printf ("\t%ld\n", ru.ru_maxrss);
+}
+
+int main (int argc, char *argv[])
+{
+	static const char *all[] = { "wide", "tower", "list", "c", NULL };
+	size_t rules = argc > 1 ? strtoul (argv[1], NULL, 0) : 3000;
+	const char **family = argc > 2 ? (const char **) argv + 2 : all;
+
+	printf ("family\trules\tsymbols\titems\tstates\tload_ms\tbuild_ms\t"
+		"lalr_ms\temit_ms\tbuild_ns_per_state\tcode_bytes\t"
+		"peak_kib\n");
+
+	for (; *family != NULL; ++family)
+		bench_run (*family, rules);
+
+	return 0;
+}
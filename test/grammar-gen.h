@@ -0,0 +1,238 @@
+/*
+ * Synthetic Grammar Generator
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TEST_GRAMMAR_GEN_H
+#define TEST_GRAMMAR_GEN_H  1
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Synthetic grammar: NULL-terminated table of rules in the format of
+ * load_grammar
+ */
+struct gen {
+	const char ***rules;
+	size_t count, size;
+};
+
+static void gen_init (struct gen *o)
+{
+	o->count = 0;
+	o->size  = 0;
+	o->rules = NULL;
+}
+
+static void gen_fini (struct gen *o)
+{
+	size_t i, j;
+
+	for (i = 0; i < o->count; ++i) {
+		for (j = 0; o->rules[i][j] != NULL; ++j)
+			free ((void *) o->rules[i][j]);
+
+		free (o->rules[i]);
+	}
+
+	free (o->rules);
+}
+
+/*
+ * Add rule: space separated list of symbols, where each occurrence of
+ * %1$zu replaced by index and %2$zu by the next index
+ */
+static void gen_add (struct gen *o, const char *fmt, size_t index)
+{
+	char line[256], *p, *name;
+	size_t len, i;
+	const char **r;
+
+	snprintf (line, sizeof (line), fmt, index, index + 1);
+
+	for (len = 1, p = line; (p = strchr (p, ' ')) != NULL; ++p, ++len) {}
+
+	if (o->count + 1 >= o->size) {
+		o->size = o->size == 0 ? 64 : o->size * 2;
+
+		if ((o->rules = realloc (o->rules,
+					 sizeof (o->rules[0]) * o->size)) == NULL)
+			err (1, "cannot allocate grammar");
+	}
+
+	if ((r = malloc (sizeof (r[0]) * (len + 1))) == NULL)
+		err (1, "cannot allocate rule");
+
+	for (i = 0, p = line; (name = strsep (&p, " ")) != NULL; ++i)
+		if ((r[i] = strdup (name)) == NULL)
+			err (1, "cannot allocate name");
+
+	r[i] = NULL;
+
+	o->rules[o->count++] = r;
+	o->rules[o->count] = NULL;
+}
+
+/*
+ * Wide declaration list:
+ *
+ *	S  → L
+ *	L  → L D | D
+ *	D  → ki Xi e
+ *	Xi → ai Xi bi | ci
+ */
+static void gen_wide (struct gen *o, size_t rules)
+{
+	size_t i, n = rules < 6 ? 1 : (rules - 1) / 3;
+
+	gen_add (o, "S L", 0);
+	gen_add (o, "L L D", 0);
+	gen_add (o, "L D", 0);
+
+	for (i = 0; i < n; ++i) {
+		gen_add (o, "D k%1$zu X%1$zu e", i);
+		gen_add (o, "X%1$zu a%1$zu X%1$zu b%1$zu", i);
+		gen_add (o, "X%1$zu c%1$zu", i);
+	}
+}
+
+/*
+ * Expression precedence tower:
+ *
+ *	S  → E0
+ *	Ei → Ei oi Ej | Ej,  j = i + 1
+ *	En → n | ( E0 )
+ */
+static void gen_tower (struct gen *o, size_t rules)
+{
+	size_t i, n = rules < 6 ? 1 : (rules - 2) / 2;
+
+	gen_add (o, "S E0", 0);
+
+	for (i = 0; i < n; ++i) {
+		gen_add (o, "E%1$zu E%1$zu o%1$zu E%2$zu", i);
+		gen_add (o, "E%1$zu E%2$zu", i);
+	}
+
+	gen_add (o, "E%1$zu n", n);
+	gen_add (o, "E%1$zu ( E0 )", n);
+}
+
+/*
+ * Long right-recursive lists:
+ *
+ *	S  → L0
+ *	Li → xi , Li | xi ; Lj,  j = i + 1
+ *	Ln → z
+ */
+static void gen_list (struct gen *o, size_t rules)
+{
+	size_t i, n = rules < 4 ? 1 : (rules - 2) / 2;
+
+	gen_add (o, "S L0", 0);
+
+	for (i = 0; i < n; ++i) {
+		gen_add (o, "L%1$zu x%1$zu , L%1$zu", i);
+		gen_add (o, "L%1$zu x%1$zu ; L%2$zu", i);
+	}
+
+	gen_add (o, "L%1$zu z", n);
+}
+
+static const char *gen_c_core[] = {
+	"S unit",
+	"unit unit external", "unit external",
+	"external type id ( params ) block", "external type id ( ) block",
+	"external type declarators ;",
+	"type int", "type char", "type void", "type long", "type double",
+	"declarators declarators , declarator", "declarators declarator",
+	"declarator id", "declarator id = assign", "declarator * declarator",
+	"declarator id [ num ]",
+	"params params , type declarator", "params type declarator",
+	"block { items }", "block { }",
+	"items items item", "items item",
+	"item type declarators ;", "item stmt",
+	"stmt block", "stmt expr ;", "stmt ;",
+	"stmt if ( expr ) block", "stmt if ( expr ) block else block",
+	"stmt while ( expr ) stmt", "stmt do stmt while ( expr ) ;",
+	"stmt for ( expr ; expr ; expr ) stmt",
+	"stmt return expr ;", "stmt return ;",
+	"stmt break ;", "stmt continue ;",
+	"expr expr , assign", "expr assign",
+	"assign cond", "assign unary assign-op assign",
+	"assign-op =", "assign-op +=", "assign-op -=", "assign-op *=",
+	"assign-op /=", "assign-op %%=", "assign-op <<=", "assign-op >>=",
+	"cond or", "cond or ? expr : cond",
+	"or or || and", "or and",
+	"and and && bit-or", "and bit-or",
+	"bit-or bit-or | xor", "bit-or xor",
+	"xor xor ^ bit-and", "xor bit-and",
+	"bit-and bit-and & eq", "bit-and eq",
+	"eq eq == rel", "eq eq != rel", "eq rel",
+	"rel rel < shift", "rel rel > shift", "rel rel <= shift",
+	"rel rel >= shift", "rel shift",
+	"shift shift << add", "shift shift >> add", "shift add",
+	"add add + mul", "add add - mul", "add mul",
+	"mul mul * cast", "mul mul / cast", "mul mul %% cast", "mul cast",
+	"cast unary", "cast ( type ) cast",
+	"unary postfix", "unary ++ unary", "unary -- unary",
+	"unary - cast", "unary ! cast", "unary ~ cast", "unary * cast",
+	"unary & cast", "unary sizeof unary",
+	"postfix primary", "postfix postfix [ expr ]",
+	"postfix postfix ( )", "postfix postfix ( args )",
+	"postfix postfix . id", "postfix postfix -> id",
+	"postfix postfix ++", "postfix postfix --",
+	"args args , assign", "args assign",
+	"primary id", "primary num", "primary str", "primary ( expr )",
+	NULL
+};
+
+/*
+ * C-like language: declarations, statements and expressions with C
+ * operator precedence, extended by type names ti, statements
+ * ki ( expr ) stmt and multiplicative operators mi up to the number of
+ * rules
+ */
+static void gen_c (struct gen *o, size_t rules)
+{
+	size_t i;
+
+	for (i = 0; gen_c_core[i] != NULL; ++i)
+		gen_add (o, gen_c_core[i], 0);
+
+	for (i = 0; o->count < rules; ++i)
+		if (i % 3 == 0)
+			gen_add (o, "type t%1$zu", i / 3);
+		else if (i % 3 == 1)
+			gen_add (o, "stmt k%1$zu ( expr ) stmt", i / 3);
+		else
+			gen_add (o, "mul mul m%1$zu cast", i / 3);
+}
+
+/*
+ * Generates grammar of the family by its name: wide, tower, list or c.
+ * Returns zero if the family is unknown.
+ */
+static int gen_family (struct gen *o, const char *family, size_t rules)
+{
+	if (strcmp (family, "wide") == 0)
+		gen_wide (o, rules);
+	else if (strcmp (family, "tower") == 0)
+		gen_tower (o, rules);
+	else if (strcmp (family, "list") == 0)
+		gen_list (o, rules);
+	else if (strcmp (family, "c") == 0)
+		gen_c (o, rules);
+	else
+		return 0;
+
+	return 1;
+}
+
+#endif  /* TEST_GRAMMAR_GEN_H */
@@ -32,41 +32,35 @@ static struct rule *rule_alloc (struct grammar *o, const char *r[])
 
 	size = offsetof (struct rule, prod) + sizeof (rule->prod[0]) * i;
 
-	if ((rule = malloc (size)) == NULL)
-		goto no_rule;
-
-	if ((rule->nt = grammar_add_symbol (o, r[0])) == NULL)
-		goto no_symbol;
+	if ((rule = grammar_alloc (o, size)) == NULL ||
+	    (rule->nt = grammar_add_symbol (o, r[0])) == NULL)
+		return NULL;
 
 	for (i = 0; r[i + 1] != NULL; ++i)
 		if ((rule->prod[i] = grammar_add_symbol (o, r[i + 1])) == NULL)
-			goto no_symbol;
+			return NULL;
 
 	rule->prod[i] = NULL;
 	return rule;
-no_symbol:
-	free (rule);
-no_rule:
-	return NULL;
 }
 
 static int load_grammar (struct grammar *o, const char **g[])
 {
+	size_t i, j, count;
 	struct rule *r;
 
-	for (; *g != NULL; ++g) {
-		if ((r = rule_alloc (o, *g)) == NULL)
-			goto no_rule;
+	for (i = 0, count = 0; g[i] != NULL; ++i)  /* symbols at most */
+		for (j = 0; g[i][j] != NULL; ++j, ++count) {}
+
+	if (!grammar_reserve (o, count))
+		return 0;
 
-		if (!symbol_insert_rule (r->nt, r))
-			goto no_insert;
-	}
+	for (; *g != NULL; ++g)
+		if ((r = rule_alloc (o, *g)) == NULL ||
+		    !symbol_insert_rule (o, r->nt, r))
+			return 0;
 
 	return 1;
-no_insert:
-	free (r);
-no_rule:
-	return 0;
 }
 
 #endif  /* TEST_GRAMMAR_RULE_H */
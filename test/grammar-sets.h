@@ -0,0 +1,64 @@
+/*
+ * Nullable, FIRST and FOLLOW Sets of Test Grammar
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TEST_GRAMMAR_SETS_H
+#define TEST_GRAMMAR_SETS_H  1
+
+#include <err.h>
+#include <stdlib.h>
+
+#include <parser/grammar-first.h>
+
+struct grammar_sets {
+	size_t count;
+	struct bitset nullable, *first, *follow;
+};
+
+/* allocates empty sets for symbols of numbered grammar, exits on error */
+static void sets_init (struct grammar_sets *o, const struct grammar *g)
+{
+	size_t i;
+
+	o->count = g->nsymbols;
+
+	if ((o->first  = malloc (sizeof (o->first[0])  * o->count)) == NULL ||
+	    (o->follow = malloc (sizeof (o->follow[0]) * o->count)) == NULL)
+		err (1, "cannot allocate sets");
+
+	bitset_init (&o->nullable);
+
+	for (i = 0; i < o->count; ++i) {
+		bitset_init (o->first  + i);
+		bitset_init (o->follow + i);
+	}
+}
+
+/* calculates sets of grammar, exits on error */
+static void sets_make (struct grammar_sets *o, const struct grammar *g)
+{
+	if (!grammar_nullable (g, &o->nullable) ||
+	    !grammar_first  (g, &o->nullable, o->first) ||
+	    !grammar_follow (g, &o->nullable, o->first, o->follow))
+		err (1, "cannot calculate FIRST and FOLLOW sets");
+}
+
+static void sets_fini (struct grammar_sets *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->count; ++i) {
+		bitset_fini (o->first  + i);
+		bitset_fini (o->follow + i);
+	}
+
+	bitset_fini (&o->nullable);
+	free (o->first);
+	free (o->follow);
+}
+
+#endif  /* TEST_GRAMMAR_SETS_H */
@@ -7,25 +7,137 @@
  */
 
 #include <err.h>
+#include <errno.h>
 #include <stdio.h>
-#include <stdlib.h>
 
 #include <parser/grammar.h>
 #include <parser/grammar-show.h>
 
 #include "grammar-rule.h"
+#include "grammar-sets.h"
 
-int main (int argc, char *argv[])
+/*
+ * Grammar with empty rules and chain of nullable symbols: A is nullable
+ * through B and C only
+ */
+const char *n0[] = { "S", "A", "B", "d", NULL };
+const char *n1[] = { "A", "B", "C", NULL };
+const char *n2[] = { "A", "a", NULL };
+const char *n3[] = { "B", "C", NULL };
+const char *n4[] = { "B", "b", NULL };
+const char *n5[] = { "C", NULL };
+const char *n6[] = { "C", "c", "C", NULL };
+
+const char **N[] = { n0, n1, n2, n3, n4, n5, n6, NULL };
+
+/* expected sets, terminals are one character names, $ is end of input */
+struct sets_expect {
+	const char *name;
+	int nullable;
+	const char *first, *follow;
+};
+
+static const struct sets_expect G_expect[] = {
+	{ "S", 0, "(n", "$"    },
+	{ "E", 0, "(n", "$)"   },
+	{ "T", 0, "n",  "$)+"  },
+	{ NULL },
+};
+
+static const struct sets_expect N_expect[] = {
+	{ "S", 0, "abcd", "$"   },
+	{ "A", 1, "abc",  "bcd" },
+	{ "B", 1, "bc",   "bcd" },
+	{ "C", 1, "c",    "bcd" },
+	{ NULL },
+};
+
+/* returns non-zero if set consists of terminals with the names */
+static int set_is (const struct grammar *g, const struct bitset *set,
+		   const char *names)
+{
+	char name[2] = { 0 };
+	const struct symbol *s;
+	size_t i;
+
+	for (i = 0; names[i] != '\0'; ++i) {
+		name[0] = names[i];
+
+		if (names[i] == '$') {
+			if (!bitset_is_member (set, g->nterms))
+				return 0;
+		}
+		else if ((s = grammar_lookup_symbol (g, name)) == NULL ||
+			 !bitset_is_member (set, s->id))
+			return 0;
+	}
+
+	return bitset_count (set) == i;
+}
+
+static void sets_check (const struct grammar *g,
+			const struct sets_expect *e)
+{
+	struct grammar_sets sets;
+	const struct symbol *s;
+	size_t i;
+
+	sets_init (&sets, g);
+	sets_make (&sets, g);
+
+	for (i = 0; i < g->nterms; ++i)
+		if (bitset_is_member (&sets.nullable, i))
+			errx (1, "terminal %s is nullable", g->symbol[i]->name);
+
+	for (; e->name != NULL; ++e) {
+		if ((s = grammar_lookup_symbol (g, e->name)) == NULL)
+			errx (1, "no symbol %s", e->name);
+
+		if (bitset_is_member (&sets.nullable, s->id) != e->nullable)
+			errx (1, "wrong nullable of %s", s->name);
+
+		if (!set_is (g, sets.first + s->id, e->first))
+			errx (1, "wrong FIRST (%s)", s->name);
+
+		if (!set_is (g, sets.follow + s->id, e->follow))
+			errx (1, "wrong FOLLOW (%s)", s->name);
+	}
+
+	sets_fini (&sets);
+}
+
+static void test_sets (const char **rules[], const struct sets_expect *e)
 {
 	struct grammar g;
 
 	if (!grammar_init (&g))
 		err (1, "cannot initialize grammar");
 
-	if (!load_grammar (&g, G))
+	if (!load_grammar (&g, rules) || !grammar_number (&g))
 		err (1, "cannot load grammar");
 
 	grammar_show (&g, stdout);
+	sets_check (&g, e);
+	grammar_fini (&g);
+}
+
+int main (int argc, char *argv[])
+{
+	struct grammar g;
+
+	test_sets (G, G_expect);
+	test_sets (N, N_expect);
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, G) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	if (!grammar_number (&g) || grammar_add_symbol (&g, "extra") == NULL ||
+	    grammar_number (&g) || errno != EBUSY)
+		errx (1, "grammar changed after numbering is not rejected");
+
 	grammar_fini (&g);
 	return 0;
 }
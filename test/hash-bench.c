@@ -0,0 +1,229 @@
+/*
+ * Hash Function Benchmark
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <data/atom.h>
+#include <data/atom-seq.h>
+#include <data/hash.h>
+#include <data/string.h>
+#include <parser/grammar.h>
+
+#include "grammar-gen.h"
+#include "grammar-rule.h"
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* previous hash: Jenkins one-at-a-time */
+static size_t oaat (size_t hash, const void *data, size_t size)
+{
+	const unsigned char *p;
+	size_t i;
+
+	for (p = data, i = 0; i < size; ++i) {
+		hash += p[i];
+		hash += (hash << 10);
+		hash ^= (hash >> 6);
+	}
+
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+
+	return hash;
+}
+
+static size_t oaat_string (const void *o)
+{
+	return oaat (0, o, strlen (o));
+}
+
+static size_t oaat_atom (const void *o)
+{
+	return oaat (0, &o, sizeof (o));
+}
+
+static size_t oaat_atom_seq (const void *o)
+{
+	const void **p = (void *) o;
+	size_t state, i;
+
+	for (state = 0, i = 0; p[i] != NULL; ++i)
+		state = oaat (state, p[i], sizeof (p[0]));
+
+	return state;
+}
+
+static volatile size_t sink;
+
+static int cmp_size (const void *a, const void *b)
+{
+	const size_t *p = a, *q = b;
+
+	return *p < *q ? -1 : *p > *q;
+}
+
+/*
+ * Reports time per key and collisions: equal full hashes, and keys
+ * landing in an occupied home slot of a table with load factor of 25-50%
+ * compared with the expected number for a random function
+ */
+static void bench (void **keys, size_t count, size_t (*fn) (const void *),
+		   const char *set, const char *name)
+{
+	size_t *h, i, size, full, slot, rounds;
+	unsigned char *used;
+	double start, time, empty, expect;
+
+	if ((h = malloc (sizeof (h[0]) * count)) == NULL)
+		err (1, "cannot allocate hashes");
+
+	for (size = 4; size / 2 < count; size *= 2) {}
+
+	if ((used = calloc (size, 1)) == NULL)
+		err (1, "cannot allocate slots");
+
+	rounds = 1 + 4000000 / count;
+	start = now ();
+
+	while (rounds-- > 0)
+		for (i = 0; i < count; ++i)
+			h[i] = fn (keys[i]);
+
+	time = (now () - start) / (1 + 4000000 / count);
+
+	for (i = 0, slot = 0; i < count; ++i)
+		if (used[h[i] & (size - 1)]++ != 0)
+			++slot;
+
+	qsort (h, count, sizeof (h[0]), cmp_size);
+
+	for (i = 1, full = 0; i < count; ++i)
+		if (h[i] == h[i - 1])
+			++full;
+
+	for (i = 0, empty = 1; i < count; ++i)  /* P (slot stays empty) */
+		empty *= 1 - 1.0 / size;
+
+	expect = count - size * (1 - empty);
+
+	printf ("%-7s %-6s: %6.1f ns/key, full collisions = %zu, "
+		"slot collisions = %zu (random %.0f)\n",
+		set, name, time * 1e9 / count, full, slot, expect);
+
+	free (used);
+	free (h);
+}
+
+/* throughput on strings of the length */
+static void bench_length (size_t len)
+{
+	const size_t count = 1024;
+	char *buf;
+	void *keys[1024];
+	size_t i, j, sum = 0;
+	double start, old, new;
+
+	if ((buf = malloc ((len + 1) * count)) == NULL)
+		err (1, "cannot allocate strings");
+
+	for (i = 0; i < count; ++i) {
+		keys[i] = buf + (len + 1) * i;
+
+		for (j = 0; j < len; ++j)
+			buf[(len + 1) * i + j] = 'a' + (i * 7 + j * 13) % 26;
+
+		buf[(len + 1) * i + len] = '\0';
+	}
+
+	start = now ();
+
+	for (j = 0; j < 100000000 / (len + 8) / count + 1; ++j)
+		for (i = 0; i < count; ++i)
+			sum += oaat_string (keys[i]);
+
+	old = (now () - start) / j / count;
+	start = now ();
+
+	for (j = 0; j < 100000000 / (len + 8) / count + 1; ++j)
+		for (i = 0; i < count; ++i)
+			sum += string_hash (keys[i]);
+
+	new = (now () - start) / j / count;
+
+	sink = sum;
+	printf ("length %4zu: oaat %8.1f MB/s, new %8.1f MB/s\n", len,
+		len / old * 1e-6, len / new * 1e-6);
+	free (buf);
+}
+
+int main (int argc, char *argv[])
+{
+	size_t rules = argc > 1 ? strtoul (argv[1], NULL, 0) : 30000;
+	const char *family = argc > 2 ? argv[2] : "wide";
+	struct gen gen;
+	struct grammar g;
+	void **names, **rules_prod;
+	size_t i, count;
+	const char *name;
+
+	gen_init (&gen);
+
+	if (!gen_family (&gen, family, rules))
+		errx (1, "unknown grammar family %s", family);
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, gen.rules) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	printf ("names = %zu, rules = %zu\n", g.names.count, g.nrules);
+
+	count = g.names.count;
+
+	if ((names = malloc (sizeof (names[0]) * count)) == NULL ||
+	    (rules_prod = malloc (sizeof (rules_prod[0]) * g.nrules)) == NULL)
+		err (1, "cannot allocate keys");
+
+	count = 0;
+
+	ht_foreach (i, name, &g.names)
+		names[count++] = (void *) name;
+
+	for (i = 0; i < g.nrules; ++i)
+		rules_prod[i] = g.rule[i]->prod;
+
+	bench (names, count, oaat_string, "names", "oaat");
+	bench (names, count, string_hash, "names", "new");
+	bench (names, count, oaat_atom,   "atoms", "oaat");
+	bench (names, count, atom_hash,   "atoms", "new");
+	bench (rules_prod, g.nrules, oaat_atom_seq, "rules", "oaat");
+	bench (rules_prod, g.nrules, atom_seq_hash, "rules", "new");
+
+	bench_length (8);
+	bench_length (32);
+	bench_length (256);
+	bench_length (4096);
+
+	free (rules_prod);
+	free (names);
+	grammar_fini (&g);
+	gen_fini (&gen);
+	return 0;
+}
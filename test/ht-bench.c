@@ -0,0 +1,228 @@
+/*
+ * Hash Table Benchmark
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Usage: ht-bench [count]
+ *
+ * Measures insertion and lookup of count keys (100000 by default), insert
+ * latencies of full and incremental resize and removal churn.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <data/hash.h>
+#include <data/ht.h>
+
+static size_t hashes, compares;
+
+static size_t str_hash (const void *o)
+{
+	++hashes;
+
+#if 1
+	return hash_string (0, o);
+#else
+	return *(const char *) o;  /* bad hash to test collisions */
+#endif
+}
+
+static int str_eq (const void *a, const void *b)
+{
+	++compares;
+
+	return strcmp (a, b) == 0;
+}
+
+static const struct data_type str_type = {
+	.hash	= str_hash,
+	.eq	= str_eq,
+};
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* average distance of entries from their home slots */
+static double probe_length (const struct ht *o)
+{
+	size_t i, sum = 0;
+	const char *s;
+
+	ht_foreach (i, s, o)
+		sum += (i - (str_hash (s) & (o->size - 1))) & (o->size - 1);
+
+	return (double) sum / o->count;
+}
+
+static void lookup (const struct ht *o, char (*keys)[24], size_t count,
+		    int hit, const char *name)
+{
+	double start, time;
+	size_t i;
+
+	compares = 0;
+	start = now ();
+
+	for (i = 0; i < count; ++i)
+		if ((ht_lookup (o, keys[i]) != NULL) != hit)
+			errx (1, "lookup of %s failed", keys[i]);
+
+	time = now () - start;
+
+	printf ("%-6s: %.1f ns/op, %.2f compares/op\n",
+		name, time * 1e9 / count, (double) compares / count);
+}
+
+/*
+ * Shows histogram of insert latencies in power of two nanosecond buckets
+ */
+static void latency (char (*keys)[24], size_t count, unsigned flags,
+		     const char *name)
+{
+	size_t hist[40] = { 0 }, i, b, ns, max = 0;
+	struct ht ht;
+	double start;
+
+	if (!ht_init (&ht, &str_type))
+		err (1, "cannot initialize hash table");
+
+	ht.flags = flags;
+
+	for (i = 0; i < count; ++i) {
+		start = now ();
+
+		if (!ht_insert (&ht, keys[i]))
+			err (1, "cannot insert key");
+
+		ns = (now () - start) * 1e9;
+		max = ns > max ? ns : max;
+
+		for (b = 0; b < 39 && ((size_t) 1 << (b + 1)) <= ns; ++b) {}
+
+		++hist[b];
+	}
+
+	printf ("\n%s insert latency, max = %zu ns:\n", name, max);
+
+	for (b = 0; b < 40; ++b)
+		if (hist[b] != 0)
+			printf ("  < %9zu ns: %zu\n", (size_t) 1 << (b + 1),
+				hist[b]);
+
+	ht_fini (&ht);
+}
+
+/*
+ * Keeps half of keys in the table while replacing them one by one:
+ * probe length should not grow with the number of removals
+ */
+static void churn (char (*keys)[24], size_t count)
+{
+	const size_t n = count / 2;
+	struct ht ht;
+	size_t i;
+	double start, time;
+
+	if (!ht_init (&ht, &str_type))
+		err (1, "cannot initialize hash table");
+
+	for (i = 0; i < n; ++i)
+		if (!ht_insert (&ht, keys[i]))
+			err (1, "cannot insert key");
+
+	printf ("\nchurn of %zu keys, probe length = %.2f\n", n,
+		probe_length (&ht));
+
+	for (i = 0, start = now (); i < count * 4; ++i) {
+		if (ht_remove (&ht, keys[i % count]) != keys[i % count])
+			errx (1, "cannot remove key");
+
+		if (!ht_insert (&ht, keys[(i + n) % count]))
+			err (1, "cannot insert key");
+
+		if ((i + 1) % n != 0)
+			continue;
+
+		time = now () - start;
+
+		printf ("  %8zu replaced: %.1f ns/op, load factor = %zu%%, "
+			"probe length = %.2f\n", i + 1, time * 1e9 / n,
+			ht.count * 100 / ht.size, probe_length (&ht));
+
+		start = now ();
+	}
+
+	ht_fini (&ht);
+}
+
+/*
+ * Measures insertion and lookup throughput, number of key comparisons
+ * and probe length
+ */
+static void bench (size_t count)
+{
+	char (*keys)[24], (*miss)[24];
+	struct ht ht;
+	size_t i;
+	double start, time;
+
+	keys = malloc (sizeof (keys[0]) * count);
+	miss = malloc (sizeof (miss[0]) * count);
+
+	if (keys == NULL || miss == NULL)
+		err (1, "cannot allocate keys");
+
+	for (i = 0; i < count; ++i) {
+		snprintf (keys[i], sizeof (keys[i]), "key-%zu", i);
+		snprintf (miss[i], sizeof (miss[i]), "miss-%zu", i);
+	}
+
+	if (!ht_init (&ht, &str_type))
+		err (1, "cannot initialize hash table");
+
+	hashes = compares = 0;
+	start = now ();
+
+	for (i = 0; i < count; ++i)
+		if (!ht_insert (&ht, keys[i]))
+			err (1, "cannot insert key");
+
+	time = now () - start;
+
+	printf ("%zu keys, load factor = %zu%%, probe length = %.2f\n",
+		count, ht.count * 100 / ht.size, probe_length (&ht));
+
+	printf ("insert: %.1f ns/op, %.2f compares/op, %.2f hashes/op\n",
+		time * 1e9 / count, (double) compares / count,
+		(double) hashes / count);
+
+	lookup (&ht, keys, count, 1, "hit");
+	lookup (&ht, miss, count, 0, "miss");
+
+	ht_fini (&ht);
+
+	latency (keys, count, 0, "full resize");
+	latency (keys, count, HT_INCREMENTAL, "incremental resize");
+	churn (keys, count);
+	free (keys);
+	free (miss);
+}
+
+int main (int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoul (argv[1], NULL, 0) : 100000;
+
+	bench (count);
+	return 0;
+}
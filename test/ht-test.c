@@ -8,7 +8,7 @@
 static size_t str_hash (const void *o)
 {
 #if 1
-	return hash (0, o, strlen (o));
+	return hash_string (0, o);
 #else
 	return *(const char *) o;  /* bad hash to test collisions */
 #endif
@@ -24,6 +24,51 @@ static const struct data_type str_type = {
 	.eq	= str_eq,
 };
 
+/*
+ * Removes every other key while incremental move is pending, from the
+ * old table as well, and checks that the rest of keys are still found
+ */
+static void test_incremental (void)
+{
+	static char keys[200][16];
+	struct ht ht;
+	size_t i, n, old;
+
+	if (!ht_init (&ht, &str_type))
+		err (1, "cannot initialize hash table");
+
+	ht.flags = HT_INCREMENTAL;
+
+	for (n = 0; n < 200 && (n < 64 || ht.old_size == 0); ++n) {
+		snprintf (keys[n], sizeof (keys[n]), "key-%zu", n);
+
+		if (!ht_insert (&ht, keys[n]))
+			err (1, "cannot insert key");
+	}
+
+	if (ht.old_size == 0)
+		errx (1, "no incremental move is pending");
+
+	for (i = 0, old = 0; i < n; i += 2) {
+		old += ht_index (&ht, keys[i]) >= ht.size;
+
+		if (ht_remove (&ht, keys[i]) != keys[i])
+			errx (1, "cannot remove %s", keys[i]);
+	}
+
+	if (old == 0 || ht.old_size == 0)
+		errx (1, "no key is removed from the old table");
+
+	for (i = 0; i < n; ++i)
+		if ((ht_lookup (&ht, keys[i]) == keys[i]) != (i % 2 != 0))
+			errx (1, "lookup of %s failed", keys[i]);
+
+	if (ht.count != n / 2)
+		errx (1, "wrong count after removal");
+
+	ht_fini (&ht);
+}
+
 int main (int argc, char *argv[])
 {
 	struct ht ht;
@@ -43,6 +88,13 @@ int main (int argc, char *argv[])
 	if (ht_insert (&ht, "test string #1"))
 		errx (1, "string exists, but not found");
 
+	if (ht_remove (&ht, "consectetur adipiscing elit") == NULL ||
+	    ht_remove (&ht, "consectetur adipiscing elit") != NULL ||
+	    ht_lookup (&ht, "test string #1") == NULL ||
+	    ht_lookup (&ht, "test string #2") == NULL ||
+	    ht.count != 5)
+		errx (1, "cannot remove string");
+
 	printf ("load factor = %zu%%\n\n", ht.count * 100 / ht.size);
 
 	for (i = 0; i < ht.size; ++i)
@@ -52,5 +104,6 @@ int main (int argc, char *argv[])
 				(const char *) ht.table[i]);
 
 	ht_fini (&ht);
+	test_incremental ();
 	return 0;
 }
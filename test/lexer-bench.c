@@ -0,0 +1,426 @@
+/*
+ * Lexical Scanner Benchmark
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Usage: lexer-bench [spec [megabytes]]
+ *
+ * Compares hand-written scanner of lexer.c with table and direct code
+ * scanners generated from lexer.g at build time and with interpreter of
+ * minimal DFA built from lexer specification (lexer.g by default) on
+ * synthetic grammar text dominated by comments and indentation. Tokens
+ * of all scanners are checked to be the same first. Time per token
+ * and number of allocations include interning of identifiers. Then the
+ * text is scanned from file read by buffers and mapped to memory, and
+ * from file and pipe read by chunks of 4 KiB, 64 KiB and 1 MiB.
+ */
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <lexer/dfa.h>
+
+#include "../lexer.h"
+#include "lexer-spec.h"
+
+/* scanners generated from lexer.g with renamed entries, see Makefile */
+void table_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  table_buf_process (struct lexer_buf *o, union lexer_type *value);
+void direct_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  direct_buf_process (struct lexer_buf *o, union lexer_type *value);
+
+typedef void buf_init_fn (struct lexer_buf *o, const lexer_input_t *buf);
+typedef int buf_process_fn (struct lexer_buf *o, union lexer_type *value);
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t nallocs;
+
+#ifdef __GLIBC__
+/* count allocations of scanners and grammar */
+
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t count, size_t size);
+extern void *__libc_realloc (void *p, size_t size);
+
+void *malloc (size_t size)
+{
+	++nallocs;
+	return __libc_malloc (size);
+}
+
+void *calloc (size_t count, size_t size)
+{
+	++nallocs;
+	return __libc_calloc (count, size);
+}
+
+void *realloc (void *p, size_t size)
+{
+	++nallocs;
+	return __libc_realloc (p, size);
+}
+#endif
+
+static void report (const char *name, size_t tokens, double time,
+		    size_t size, size_t allocs)
+{
+	printf ("%-6s %9zu tokens  %8.2f ms  %6.2f ns/token  %8.1f MB/s  "
+		"%zu allocs\n", name, tokens, time * 1e3, time * 1e9 / tokens,
+		size / time * 1e-6, allocs);
+}
+
+static int write_all (int fd, const char *p, size_t size)
+{
+	ssize_t len;
+
+	for (; size > 0; p += len, size -= len)
+		if ((len = write (fd, p, size)) < 0)
+			return -1;
+
+	return 0;
+}
+
+/* returns grammar text of given size with documented rules */
+static char *gen_text (size_t size)
+{
+	char *text, *p;
+	size_t i, room;
+	int len;
+
+	if ((text = malloc (size + 256)) == NULL)
+		err (1, "cannot allocate text");
+
+	for (p = text, i = 0; p < text + size; p += len, ++i) {
+		room = text + size + 256 - p;
+		len = snprintf (p, room,
+				"# rule-%zu: a list of items separated by "
+				"commas or by semicolons\n"
+				"#\n"
+				"item-list-%zu\n"
+				"\t: item-list-%zu comma item-%zu\n"
+				"\t| item-%zu semicolon item-list-%zu\n"
+				"\t| item-%zu\n"
+				"\t;\n\n", i, i % 97, i % 97, i % 31, i % 31,
+				(i + 1) % 97, i % 31);
+	}
+
+	*p = '\0';
+	return text;
+}
+
+/* checks that scanner produces the same tokens as lexer.c */
+static void check_buf (const char *name, buf_init_fn *init,
+		       buf_process_fn *process, const char *text)
+{
+	struct grammar g;
+	struct lexer_buf a, b;
+	union lexer_type x, y;
+	int token;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	lexer_buf_init (&a, text);
+	init (&b, text);
+	a.grammar = b.grammar = &g;
+
+	do {
+		token = lexer_buf_process (&a, &x);
+
+		if (process (&b, &y) != token || (token > 0 &&
+		    (a.start != b.start || a.stop != b.stop)) ||
+		    (token == LEXER_ID && x.symbol != y.symbol))
+			errx (1, "%s: token mismatch at %zu", name,
+			      (size_t) (a.start - text));
+	}
+	while (token > 0);
+
+	grammar_fini (&g);
+}
+
+/* checks that automaton matches the same tokens as lexer.c */
+static void check (const struct lexer_dfa *dfa, const char *text)
+{
+	struct grammar g;
+	struct lexer_buf b;
+	union lexer_type value;
+	const char *p;
+	size_t len;
+	int token, expect;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	lexer_buf_init (&b, text);
+	b.grammar = &g;
+
+	for (p = text;; p += len) {
+		while ((expect = lexer_dfa_scan (dfa, p, &len)) > 0 &&
+		       lexer_spec_rule (dfa->spec, expect - 1)->ignore)
+			p += len;
+
+		token = lexer_buf_process (&b, &value);
+
+		if (token != expect || (token > 0 &&
+		    (b.start != p || b.stop != p + len)))
+			errx (1, "token mismatch at %zu", (size_t) (p - text));
+
+		if (token <= 0)
+			break;
+	}
+
+	grammar_fini (&g);
+}
+
+static void bench_buf (const char *name, buf_init_fn *init,
+		       buf_process_fn *process, const char *text, size_t size)
+{
+	struct grammar g;
+	struct lexer_buf b;
+	union lexer_type value;
+	size_t tokens, allocs;
+	double start, time;
+	int token;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	init (&b, text);
+	b.grammar = &g;
+
+	allocs = nallocs;
+	start = now ();
+
+	for (tokens = 0; (token = process (&b, &value)) > 0;)
+		++tokens;
+
+	time = now () - start;
+	allocs = nallocs - allocs;
+
+	if (token != 0)
+		errx (1, "%s: no match at %zu", name, (size_t) (b.stop - text));
+
+	report (name, tokens, time, size, allocs);
+
+	grammar_fini (&g);
+}
+
+static void bench_dfa (const struct lexer_dfa *dfa, const char *text,
+		       size_t size)
+{
+	struct grammar g;
+	const char *p;
+	size_t tokens, len, allocs;
+	double start, time;
+	int token;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	allocs = nallocs;
+	start = now ();
+
+	for (p = text, tokens = 0;
+	     (token = lexer_dfa_scan (dfa, p, &len)) > 0; p += len) {
+		if (lexer_spec_rule (dfa->spec, token - 1)->ignore)
+			continue;
+
+		/* action of lexer.g for identifiers */
+		if (token == LEXER_ID)
+			grammar_add_slice (&g, p, len);
+
+		++tokens;
+	}
+
+	time = now () - start;
+	allocs = nallocs - allocs;
+
+	if (token != 0)
+		errx (1, "dfa: no match at %zu", (size_t) (p - text));
+
+	report ("dfa", tokens, time, size, allocs);
+
+	grammar_fini (&g);
+}
+
+typedef int input_init_fn (struct lexer *o, FILE *f);
+
+/* scans file through generic lexer input, startup time is reported */
+static void bench_input (const char *name, input_init_fn *init, FILE *f,
+			 size_t size)
+{
+	struct grammar g;
+	struct lexer o;
+	union lexer_type value;
+	size_t tokens;
+	double start, mid, time;
+	int token;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	rewind (f);
+	start = now ();
+
+	if (!init (&o, f))
+		err (1, "%s: cannot initialize lexer", name);
+
+	o.lexer_buf.grammar = &g;
+	mid = now ();
+
+	for (tokens = 0; (token = lexer_process (&o, &value)) > 0;)
+		++tokens;
+
+	time = now () - start;
+
+	if (token != 0)
+		errx (1, "%s: no match after %zu tokens", name, tokens);
+
+	printf ("%-6s %9zu tokens  %8.2f ms  %8.3f ms startup  "
+		"%8.1f MB/s\n", name, tokens, time * 1e3, (mid - start) * 1e3,
+		size / time * 1e-6);
+
+	lexer_fini (&o);
+	grammar_fini (&g);
+}
+
+struct stream {
+	int fd;
+	size_t reads;
+};
+
+static int stream_read (lexer_input_t *buf, size_t count, void *cookie)
+{
+	struct stream *o = cookie;
+
+	++o->reads;
+	return read (o->fd, buf, count);
+}
+
+/* scans stream read by chunks, read system calls are counted */
+static void bench_stream (const char *name, int fd, size_t chunk,
+			  size_t size)
+{
+	struct grammar g;
+	struct stream s = { fd, 0 };
+	struct lexer o;
+	union lexer_type value;
+	size_t tokens;
+	double start, time;
+	int token;
+
+	if (!grammar_init (&g) || !lexer_init (&o, &s, stream_read))
+		err (1, "cannot initialize lexer");
+
+	o.chunk = chunk;
+	o.lexer_buf.grammar = &g;
+
+	start = now ();
+
+	for (tokens = 0; (token = lexer_process (&o, &value)) > 0;)
+		++tokens;
+
+	time = now () - start;
+
+	if (token != 0)
+		errx (1, "%s: no match after %zu tokens", name, tokens);
+
+	printf ("%-6s %9zu tokens  %8.2f ms  %8.1f MB/s  %7zu reads  "
+		"%8.1f reads/MB  %zu KiB chunk\n", name, tokens, time * 1e3,
+		size / time * 1e-6, s.reads, s.reads / (size * 1e-6),
+		chunk >> 10);
+
+	lexer_fini (&o);
+	grammar_fini (&g);
+}
+
+/* scans text written to pipe by child process */
+static void bench_pipe (const char *text, size_t chunk, size_t size)
+{
+	int fd[2];
+	pid_t pid;
+
+	if (pipe (fd) != 0 || (pid = fork ()) < 0)
+		err (1, "cannot start writer");
+
+	if (pid == 0) {
+		close (fd[0]);
+
+		if (write_all (fd[1], text, size) != 0)
+			err (1, "cannot write to pipe");
+
+		_exit (0);
+	}
+
+	close (fd[1]);
+	bench_stream ("pipe", fd[0], chunk, size);
+	close (fd[0]);
+	waitpid (pid, NULL, 0);
+}
+
+int main (int argc, char *argv[])
+{
+	const char *path = argc > 1 ? argv[1] : SRCDIR "/lexer.g";
+	size_t size = (argc > 2 ? atoi (argv[2]) : 16) << 20;
+	struct lexer_spec s;
+	struct lexer_dfa dfa;
+	char *text;
+	FILE *f;
+	size_t chunk;
+
+	load_spec (&s, path);
+
+	if (!lexer_dfa_init (&dfa, &s))
+		err (1, "cannot build automaton");
+
+	text = gen_text (size);
+	size = strlen (text);
+
+	printf ("%s: %zu states, %zu classes, %zu bytes of text\n", path,
+		dfa.nstates, dfa.nclasses, size);
+
+	check_buf ("table",  table_buf_init,  table_buf_process,  text);
+	check_buf ("direct", direct_buf_init, direct_buf_process, text);
+	check (&dfa, text);
+
+	bench_buf ("hand", lexer_buf_init, lexer_buf_process, text, size);
+	bench_buf ("table", table_buf_init, table_buf_process, text, size);
+	bench_buf ("direct", direct_buf_init, direct_buf_process, text, size);
+	bench_dfa (&dfa, text, size);
+
+	if ((f = tmpfile ()) == NULL || fwrite (text, 1, size, f) != size ||
+	    fflush (f) != 0)
+		err (1, "cannot write text to file");
+
+	bench_input ("file", lexer_file_init, f, size);
+	bench_input ("mmap", lexer_mmap_init, f, size);
+
+	for (chunk = 4096; chunk <= (1 << 20); chunk *= 16) {
+		lseek (fileno (f), 0, SEEK_SET);
+		bench_stream ("fd", fileno (f), chunk, size);
+		bench_pipe (text, chunk, size);
+	}
+
+	fclose (f);
+
+	free (text);
+	lexer_dfa_fini (&dfa);
+	lexer_spec_fini (&s);
+	return 0;
+}
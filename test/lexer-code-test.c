@@ -0,0 +1,104 @@
+/*
+ * Generated Lexer Code Test
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Usage: lexer-code-test [spec]
+ *
+ * Compares tokens of table and direct code scanners generated from
+ * test/lexer-code.g at build time with matches of minimal DFA built from
+ * the same specification.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <lexer/dfa.h>
+
+#include "code/lexer.h"
+#include "lexer-spec.h"
+
+/* scanners generated with renamed entries, see Makefile */
+void table_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  table_buf_process (struct lexer_buf *o, union lexer_type *value);
+void direct_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  direct_buf_process (struct lexer_buf *o, union lexer_type *value);
+
+typedef void buf_init_fn (struct lexer_buf *o, const lexer_input_t *buf);
+typedef int buf_process_fn (struct lexer_buf *o, union lexer_type *value);
+
+static const char *input[] = {
+	"", "c", "abc", "ababcde", "ab ab c", "abcd", "abcdx", "ababcd c",
+	"abab", "aba", "cde cd", " abcde  ababc", NULL,
+};
+
+/* checks that scanner matches the same tokens as automaton */
+static void check (const struct lexer_dfa *dfa, const char *name,
+		   buf_init_fn *init, buf_process_fn *process,
+		   const char *text)
+{
+	struct lexer_buf b;
+	union lexer_type value;
+	const char *p;
+	size_t len;
+	int token, expect;
+
+	init (&b, text);
+
+	for (p = text;; p += len) {
+		while ((expect = lexer_dfa_scan (dfa, p, &len)) > 0 &&
+		       lexer_spec_rule (dfa->spec, expect - 1)->ignore)
+			p += len;
+
+		token = process (&b, &value);
+
+		if (token != expect || (token > 0 &&
+		    (b.start != p || b.stop != p + len)))
+			errx (1, "%s: token mismatch at %zu in \"%s\"", name,
+			      (size_t) (p - text), text);
+
+		if (token <= 0)
+			break;
+	}
+}
+
+static void check_all (const struct lexer_dfa *dfa, const char *text)
+{
+	check (dfa, "table",  table_buf_init,  table_buf_process,  text);
+	check (dfa, "direct", direct_buf_init, direct_buf_process, text);
+}
+
+int main (int argc, char *argv[])
+{
+	static const char alphabet[] = "abcde x";
+	const char *path = argc > 1 ? argv[1] : SRCDIR "/test/lexer-code.g";
+	struct lexer_spec s;
+	struct lexer_dfa dfa;
+	char text[41];
+	size_t i, j, len;
+
+	load_spec (&s, path);
+
+	if (!lexer_dfa_init (&dfa, &s))
+		err (1, "cannot build automaton");
+
+	for (i = 0; input[i] != NULL; ++i)
+		check_all (&dfa, input[i]);
+
+	for (i = 0; i < 10000; ++i) {
+		len = rand () % (sizeof (text) - 1);
+
+		for (j = 0; j < len; ++j)
+			text[j] = alphabet[rand () % (sizeof (alphabet) - 1)];
+
+		text[len] = '\0';
+		check_all (&dfa, text);
+	}
+
+	lexer_dfa_fini (&dfa);
+	lexer_spec_fini (&s);
+	return 0;
+}
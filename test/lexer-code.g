@@ -0,0 +1,13 @@
+# Lexer Code Test Specification
+#
+# Copyright (c) 2017 Alexei A. Smekalkine
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Every rule starts with the same loop, thus the start state is reached
+# again after each "ab". Rule long needs backtracking to short on "abcd"
+# not followed by 'e'.
+
+blank*	: ('a' 'b')* ' ' ;
+short	: ('a' 'b')* 'c' ;
+long	: ('a' 'b')* 'c' 'd' 'e' ;
@@ -0,0 +1,51 @@
+/*
+ * Lexical Scanner Generator
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Usage: lexer-gen spec (header|table|direct)
+ *
+ * Writes declarations or scanner of specification to standard output.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <lexer/code.h>
+#include <lexer/dfa.h>
+
+#include "lexer-spec.h"
+
+int main (int argc, char *argv[])
+{
+	struct lexer_spec s;
+	struct lexer_dfa dfa;
+	int ok;
+
+	if (argc != 3)
+		errx (1, "usage: lexer-gen spec (header|table|direct)");
+
+	load_spec (&s, argv[1]);
+
+	if (!lexer_dfa_init (&dfa, &s))
+		err (1, "cannot build automaton");
+
+	if (strcmp (argv[2], "header") == 0)
+		ok = lexer_header_code (&s, stdout);
+	else if (strcmp (argv[2], "table") == 0)
+		ok = lexer_table_code (&dfa, stdout);
+	else if (strcmp (argv[2], "direct") == 0)
+		ok = lexer_direct_code (&dfa, stdout);
+	else
+		errx (1, "unknown output %s", argv[2]);
+
+	if (!ok)
+		err (1, "cannot write %s", argv[2]);
+
+	lexer_dfa_fini (&dfa);
+	lexer_spec_fini (&s);
+	return 0;
+}
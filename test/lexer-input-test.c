@@ -0,0 +1,282 @@
+/*
+ * Lexical Scanner Input Test
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Checks that scanning of input read by short chunks and of mapped files
+ * gives the same tokens as scanning of the whole text in memory, that
+ * scanners generated from lexer.g agree with lexer.c on random texts, and
+ * that vector skips of blanks and comments stop right at every alignment.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include "../lexer.h"
+
+/* widest vector group of lexer.c */
+#define GROUP  32
+
+/* checks that scanner gives the same tokens as lexer_buf_process */
+static void check (struct lexer *o, const char *text, const char *name)
+{
+	struct grammar g, h;
+	struct lexer_buf b;
+	union lexer_type x, y;
+	size_t len;
+	int token;
+
+	if (!grammar_init (&g) || !grammar_init (&h))
+		err (1, "cannot initialize grammar");
+
+	lexer_buf_init (&b, text);
+	b.grammar = &g;
+	o->lexer_buf.grammar = &h;
+
+	do {
+		token = lexer_buf_process (&b, &x);
+		len = b.stop - b.start;
+
+		if (lexer_process (o, &y) != token || (token > 0 &&
+		    (o->lexer_buf.stop - o->lexer_buf.start != len ||
+		     memcmp (o->lexer_buf.start, b.start, len) != 0)) ||
+		    (token == LEXER_ID && strcmp (x.symbol->name,
+						  y.symbol->name) != 0))
+			errx (1, "%s: token mismatch at %zu in \"%s\"", name,
+			      (size_t) (b.start - text), text);
+	}
+	while (token > 0);
+
+	grammar_fini (&h);
+	grammar_fini (&g);
+}
+
+/* scanners generated from lexer.g with renamed entries, see Makefile */
+void table_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  table_buf_process (struct lexer_buf *o, union lexer_type *value);
+void direct_buf_init (struct lexer_buf *o, const lexer_input_t *buf);
+int  direct_buf_process (struct lexer_buf *o, union lexer_type *value);
+
+typedef void buf_init_fn (struct lexer_buf *o, const lexer_input_t *buf);
+typedef int buf_process_fn (struct lexer_buf *o, union lexer_type *value);
+
+/* checks that generated scanner gives the same tokens as lexer.c */
+static void check_buf (const char *name, buf_init_fn *init,
+		       buf_process_fn *process, const char *text)
+{
+	struct grammar g;
+	struct lexer_buf a, b;
+	union lexer_type x, y;
+	int token;
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	lexer_buf_init (&a, text);
+	init (&b, text);
+	a.grammar = b.grammar = &g;
+
+	do {
+		token = lexer_buf_process (&a, &x);
+
+		if (process (&b, &y) != token || (token > 0 &&
+		    (a.start != b.start || a.stop != b.stop)) ||
+		    (token == LEXER_ID && x.symbol != y.symbol))
+			errx (1, "%s: token mismatch at %zu in \"%s\"", name,
+			      (size_t) (a.start - text), text);
+	}
+	while (token > 0);
+
+	grammar_fini (&g);
+}
+
+struct source {
+	const char *text;
+	size_t len, pos;
+};
+
+/* reads from one to eight items, at most count */
+static int source_read (lexer_input_t *buf, size_t count, void *cookie)
+{
+	struct source *o = cookie;
+	size_t len = o->len - o->pos;
+
+	if (len > count)
+		len = count;
+
+	if (len > 8)
+		len = 8;
+
+	if (len > 1)
+		len = 1 + rand () % len;
+
+	memcpy (buf, o->text + o->pos, len);
+	o->pos += len;
+	return len;
+}
+
+static void test_reads (void)
+{
+	static const char alphabet[] = "  \t\n\n#abc-:|;xY9- \t";
+	char text[201];
+	struct source s;
+	struct lexer o;
+	size_t i, len;
+	int n;
+
+	for (n = 0; n < 20000; ++n) {
+		len = rand () % (sizeof (text) - 1);
+
+		for (i = 0; i < len; ++i)
+			text[i] = alphabet[rand () % (sizeof (alphabet) - 1)];
+
+		text[len] = '\0';
+
+		s.text = text;
+		s.len  = len;
+		s.pos  = 0;
+
+		if (!lexer_init (&o, &s, source_read))
+			err (1, "cannot initialize lexer");
+
+		o.chunk = 1 + rand () % 8;
+		check (&o, text, "reads");
+		lexer_fini (&o);
+
+		check_buf ("table",  table_buf_init,  table_buf_process,  text);
+		check_buf ("direct", direct_buf_init, direct_buf_process, text);
+	}
+}
+
+/* maps file ending with comment and checks it against text in memory */
+static void test_mmap_size (size_t size)
+{
+	static const char head[] = "a : b-1 | c ;\n# ";
+	char *text;
+	size_t i;
+	FILE *f;
+	struct lexer o;
+
+	if ((text = malloc (size + 1)) == NULL)
+		err (1, "cannot allocate text");
+
+	for (i = 0; i < size; ++i)
+		text[i] = i < sizeof (head) - 1 ? head[i] : 'x';
+
+	text[size] = '\0';
+
+	if ((f = tmpfile ()) == NULL || fwrite (text, 1, size, f) != size ||
+	    fflush (f) != 0)
+		err (1, "cannot write text to file");
+
+	if (!lexer_mmap_init (&o, f))
+		err (1, "cannot map file of %zu bytes", size);
+
+	if (o.read != NULL)
+		errx (1, "file of %zu bytes is not mapped", size);
+
+	check (&o, text, "mmap");
+
+	lexer_fini (&o);
+	fclose (f);
+	free (text);
+}
+
+static void test_mmap (void)
+{
+	const size_t page = sysconf (_SC_PAGESIZE);
+
+	test_mmap_size (0);
+	test_mmap_size (1);
+	test_mmap_size (page - 1);
+	test_mmap_size (page);
+	test_mmap_size (2 * page);
+}
+
+static void expect (struct lexer_buf *o, const char *base, int token,
+		    size_t start, size_t len)
+{
+	union lexer_type value;
+	int got = lexer_buf_process (o, &value);
+
+	if (got != token || (token > 0 &&
+	    (o->start != base + start || o->stop != base + start + len)))
+		errx (1, "skip: got %d at %zu of length %zu, expected %d at "
+		      "%zu", got, (size_t) (o->start - base),
+		      (size_t) (o->stop - o->start), token, start);
+}
+
+/*
+ * Runs of blanks and comments of lengths up to two groups start at
+ * every offset within a group. Bytes after the terminating NUL are not
+ * blank to catch scans past it.
+ */
+static void test_skip (void)
+{
+	static const char blanks[] = " \t\n";
+	const size_t size = 6 * GROUP;
+	struct grammar g;
+	struct lexer_buf b;
+	char *buf, *p;
+	size_t off, n, i, tail;
+
+	if ((buf = aligned_alloc (GROUP, size)) == NULL ||
+	    !grammar_init (&g))
+		err (1, "cannot initialize skip test");
+
+	for (off = 0; off < GROUP; ++off)
+	for (n = 1; n <= 2 * GROUP; ++n)
+	for (tail = 0; tail < 3; ++tail) {
+		memset (buf, 'z', size);
+		p = buf + off;
+
+		/* a, blanks, b, comment of n bytes, then c, NUL or blanks */
+		p[0] = 'a';
+
+		for (i = 0; i < n; ++i)
+			p[1 + i] = blanks[i % 3];
+
+		p[1 + n] = 'b';
+		p[2 + n] = '#';
+		memset (p + 3 + n, 'x', n);
+		p[3 + 2 * n] = tail == 0 ? '\n' : '\0';
+		p[4 + 2 * n] = tail == 0 ? 'c' : 'x';
+		p[5 + 2 * n] = '\0';
+
+		if (tail == 2) {
+			p[2 + n] = ' ';
+			memset (p + 3 + n, '\t', n);
+			p[3 + 2 * n] = '\0';
+		}
+
+		lexer_buf_init (&b, p);
+		b.grammar = &g;
+
+		expect (&b, p, LEXER_ID, 0, 1);
+		expect (&b, p, LEXER_ID, 1 + n, 1);
+
+		if (tail == 0)
+			expect (&b, p, LEXER_ID, 4 + 2 * n, 1);
+
+		expect (&b, p, 0, 0, 0);
+	}
+
+	grammar_fini (&g);
+	free (buf);
+}
+
+int main (void)
+{
+	srand (1);
+
+	test_reads ();
+	test_mmap ();
+	test_skip ();
+	return 0;
+}
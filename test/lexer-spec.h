@@ -0,0 +1,60 @@
+/*
+ * Lexer Specification Loader
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TEST_LEXER_SPEC_H
+#define TEST_LEXER_SPEC_H  1
+
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <lexer/spec.h>
+
+/* returns NUL-terminated contents of file, exits on error */
+static char *load_text (const char *path)
+{
+	FILE *f;
+	char *text;
+	long size;
+
+	if ((f = fopen (path, "rb")) == NULL ||
+	    fseek (f, 0, SEEK_END) != 0 || (size = ftell (f)) < 0 ||
+	    fseek (f, 0, SEEK_SET) != 0)
+		err (1, "cannot open %s", path);
+
+	if ((text = malloc (size + 1)) == NULL)
+		err (1, "cannot allocate text");
+
+	if (fread (text, 1, size, f) != (size_t) size)
+		err (1, "cannot read %s", path);
+
+	text[size] = '\0';
+	fclose (f);
+	return text;
+}
+
+/* parses specification from file, exits on error */
+static void load_spec (struct lexer_spec *o, const char *path)
+{
+	char *text = load_text (path);
+
+	if (!lexer_spec_init (o))
+		err (1, "cannot initialize specification");
+
+	if (!lexer_spec_parse (o, text)) {
+		if (errno == EINVAL)
+			errx (1, "%s:%zu: syntax error", path, o->line);
+
+		err (1, "cannot parse %s", path);
+	}
+
+	free (text);
+}
+
+#endif  /* TEST_LEXER_SPEC_H */
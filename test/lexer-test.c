@@ -0,0 +1,97 @@
+/*
+ * Lexer Generator Test
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <lexer/dfa.h>
+
+#include "lexer-spec.h"
+
+static const char *input =
+	"# comment\n"
+	"rule-list : rule-list rule | rule ;\n"
+	"a-: x9|y;";
+
+/* token and length of expected matches, ignored ones included */
+static const int expect[][2] = {
+	{ 1, 9 }, { 2, 1 }, { 3, 9 }, { 2, 1 }, { 4, 1 }, { 2, 1 },
+	{ 3, 9 }, { 2, 1 }, { 3, 4 }, { 2, 1 }, { 5, 1 }, { 2, 1 },
+	{ 3, 4 }, { 2, 1 }, { 6, 1 }, { 2, 1 }, { 3, 1 }, { -1, 0 },
+};
+
+/* braces in literals and comments of actions are not counted */
+static const char *actions =
+	"a : 'a' { putchar ('}'); } ;\n"
+	"b : 'b' { puts (\"{\\\"}\"); /* } */ } ;\n"
+	"c : 'c' { // }\n"
+	"\tputchar ('\\''); } ;\n";
+
+static const char *action[] = {
+	"putchar ('}');",
+	"puts (\"{\\\"}\"); /* } */",
+	"// }\n\tputchar ('\\'');",
+};
+
+static void test_actions (void)
+{
+	struct lexer_spec s;
+	size_t i;
+
+	if (!lexer_spec_init (&s) || !lexer_spec_parse (&s, actions))
+		err (1, "cannot parse actions");
+
+	if (s.rules.count != 3)
+		errx (1, "wrong number of rules with actions");
+
+	for (i = 0; i < 3; ++i)
+		if (strcmp (lexer_spec_rule (&s, i)->action, action[i]) != 0)
+			errx (1, "wrong action of rule %zu: %s", i,
+			      lexer_spec_rule (&s, i)->action);
+
+	lexer_spec_fini (&s);
+}
+
+int main (int argc, char *argv[])
+{
+	const char *path = argc > 1 ? argv[1] : SRCDIR "/lexer.g";
+	struct lexer_spec s;
+	struct lexer_dfa dfa;
+	const char *p;
+	size_t i, len;
+	int token;
+
+	load_spec (&s, path);
+
+	if (s.rules.count != 6 || !lexer_spec_rule (&s, 0)->ignore ||
+	    lexer_spec_rule (&s, 2)->action == NULL ||
+	    strcmp (s.context, "struct grammar *grammar;") != 0)
+		errx (1, "wrong specification");
+
+	if (!lexer_dfa_init (&dfa, &s))
+		err (1, "cannot build automaton");
+
+	fprintf (stderr, "states = %zu, classes = %zu\n", dfa.nstates,
+		 dfa.nclasses);
+
+	for (p = input, i = 0; (token = lexer_dfa_scan (&dfa, p, &len)) > 0;
+	     p += len, ++i)
+		if (token != expect[i][0] || len != (size_t) expect[i][1])
+			errx (1, "token %zu: got %d of length %zu", i, token,
+			      len);
+
+	if (token != expect[i][0])
+		errx (1, "token %zu: got %d", i, token);
+
+	lexer_dfa_fini (&dfa);
+	lexer_spec_fini (&s);
+
+	test_actions ();
+	return 0;
+}
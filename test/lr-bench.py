@@ -0,0 +1,64 @@
+#!/usr/bin/python3
+#
+# LR Automata Build Benchmark for reference implementation in test.py
+#
+# Copyright (c) 2017 Alexei A. Smekalkine
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Usage: lr-bench.py [rules [family]], see also automata-bench.c
+
+import contextlib, io, os, runpy, sys, time
+
+sys.setrecursionlimit (1000000)
+
+with contextlib.redirect_stdout (io.StringIO ()):
+	path = os.path.join (os.path.dirname (__file__), '..', 'test.py')
+	ns = runpy.run_path (path)
+
+Rule = ns['Rule']
+
+def gen_wide (n):
+	n = 1 if n < 6 else (n - 1) // 3
+
+	rules = [Rule ('S', ['L']), Rule ('L', ['L', 'D']), Rule ('L', ['D'])]
+
+	for i in range (n):
+		k, X, a, b, c = ('{}{}'.format (p, i) for p in 'kXabc')
+
+		rules.append (Rule ('D', [k, X, 'e']))
+		rules.append (Rule (X, [a, X, b]))
+		rules.append (Rule (X, [c]))
+
+	return rules
+
+def gen_tower (n):
+	n = 1 if n < 6 else (n - 2) // 2
+
+	rules = [Rule ('S', ['E0'])]
+
+	for i in range (n):
+		E, o, F = 'E{}'.format (i), 'o{}'.format (i), 'E{}'.format (i + 1)
+
+		rules.append (Rule (E, [E, o, F]))
+		rules.append (Rule (E, [F]))
+
+	E = 'E{}'.format (n)
+
+	rules.append (Rule (E, ['n']))
+	rules.append (Rule (E, ['(', 'E0', ')']))
+	return rules
+
+rules  = int (sys.argv[1]) if len (sys.argv) > 1 else 300
+family = sys.argv[2] if len (sys.argv) > 2 else 'wide'
+G      = {'wide': gen_wide, 'tower': gen_tower}[family] (rules)
+
+print ('rules = {}'.format (len (G)))
+
+for name in ['SLR', 'LR1']:
+	start = time.perf_counter ()
+	m = ns[name] (G)
+	stop = time.perf_counter ()
+
+	print ('{:6}: states = {}, build = {:.3f} ms'.format (name, m.count,
+	       (stop - start) * 1e3))
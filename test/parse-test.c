@@ -0,0 +1,144 @@
+/*
+ * LR Parser Runtime Test
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <ctype.h>
+#include <err.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <parser/automata-build.h>
+#include <parser/automata-lalr.h>
+#include <parser/automata-parse.h>
+#include <parser/grammar.h>
+
+#include "grammar-rule.h"
+
+struct input {
+	struct grammar *g;
+	const char *p;
+};
+
+/* digits are tokens n with value, other characters are terminals */
+static int input_lex (void *cookie, void **value)
+{
+	struct input *o = cookie;
+	char name[2] = { 0 };
+	struct symbol *s;
+
+	*value = NULL;
+
+	for (; isspace (*o->p); ++o->p) {}
+
+	if (*o->p == '\0')
+		return o->g->nterms;
+
+	if (isdigit (*o->p)) {
+		*value = (void *) (intptr_t) (*o->p++ - '0');
+		name[0] = 'n';
+	}
+	else
+		name[0] = *o->p++;
+
+	/* the grammar is numbered already, unknown characters are errors */
+	if ((s = grammar_lookup_symbol (o->g, name)) == NULL ||
+	    s->rules != NULL)
+		return -1;
+
+	return s->id;
+}
+
+/* value of every non-terminal is a sum of values of its production */
+static void *input_reduce (void *cookie, const struct rule *r, void **args)
+{
+	intptr_t sum = 0;
+	size_t i;
+
+	for (i = 0; r->prod[i] != NULL; ++i)
+		sum += (intptr_t) args[i];
+
+	return (void *) sum;
+}
+
+static void test (struct automata_parser *c, const char *text, int ok,
+		  intptr_t expect)
+{
+	struct input in = { (void *) c->cookie, text };
+	void *result;
+
+	c->cookie = &in;
+
+	if (automata_parse (c, &result) != ok ||
+	    (ok && (intptr_t) result != expect) || (!ok && errno != EINVAL))
+		errx (1, "parse of \"%s\" failed", text);
+
+	c->cookie = in.g;
+	printf ("%s: %s\n", text, ok ? "ok" : "syntax error");
+}
+
+int main (int argc, char *argv[])
+{
+	struct grammar g;
+	struct automata a;
+	struct automata_table t;
+	struct automata_parser c;
+	char deep[256];
+	size_t i;
+
+	/* nesting exceeds the initial stack size */
+	for (i = 0; i < 100; ++i) {
+		deep[i] = '(';
+		deep[i + 105] = ')';
+	}
+
+	memcpy (deep + 100, "7 + 8", 5);
+	deep[205] = '\0';
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, G) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	if (!automata_init (&a))
+		err (1, "cannot initialize automata");
+
+	if (!automata_build (&a, &g) || !automata_lalr (&a))
+		err (1, "cannot build automata");
+
+	if (!automata_table_init (&t, &a))
+		err (1, "cannot build tables");
+
+	if (!automata_parser_init (&c, &t))
+		err (1, "cannot initialize parser");
+
+	c.lex    = input_lex;
+	c.reduce = input_reduce;
+	c.cookie = &g;
+
+	test (&c, "1", 1, 1);
+	test (&c, "1 + 2 + 3", 1, 6);
+	test (&c, deep, 1, 15);
+	test (&c, "", 0, 0);
+	test (&c, "1 +", 0, 0);
+	test (&c, "(1 + 2", 0, 0);
+	test (&c, "1 2", 0, 0);
+	test (&c, "(1) + 2", 0, 0);
+	test (&c, "?", 0, 0);
+
+	if (g.symbols.count != g.nsymbols)
+		errx (1, "input added symbols to the numbered grammar");
+
+	automata_parser_fini (&c);
+	automata_table_fini (&t);
+	automata_fini (&a);
+	grammar_fini (&g);
+	return 0;
+}
@@ -0,0 +1,265 @@
+/*
+ * Parser Table Benchmark
+ *
+ * Copyright (c) 2017 Alexei A. Smekalkine
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <parser/automata-build.h>
+#include <parser/automata-code.h>
+#include <parser/automata-lalr.h>
+#include <parser/automata-parse.h>
+#include <parser/automata-table.h>
+#include <parser/grammar.h>
+
+#include "grammar-gen.h"
+#include "grammar-rule.h"
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t token (struct grammar *g, const char *fmt, size_t index)
+{
+	char name[32];
+
+	snprintf (name, sizeof (name), fmt, index);
+	return grammar_add_symbol (g, name)->id;
+}
+
+/*
+ * Sentence of the wide grammar: declarations ki ai^m ci bi^m e with
+ * pseudo-random i and m, terminated by the end of input
+ */
+static size_t *wide_input (struct grammar *g, size_t n, size_t len,
+			   size_t *count)
+{
+	size_t *p, i, j, m, k = 0;
+	unsigned long seed = 1;
+
+	if ((p = malloc (sizeof (p[0]) * (len + 16))) == NULL)
+		err (1, "cannot allocate input");
+
+	while (k < len) {
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+		i = (seed >> 33) % n;
+		m = (seed >> 13) % 4;
+
+		if (k + 2 * m + 4 > len)
+			break;
+
+		p[k++] = token (g, "k%zu", i);
+
+		for (j = 0; j < m; ++j)
+			p[k++] = token (g, "a%zu", i);
+
+		p[k++] = token (g, "c%zu", i);
+
+		for (j = 0; j < m; ++j)
+			p[k++] = token (g, "b%zu", i);
+
+		p[k++] = token (g, "e", 0);
+	}
+
+	p[k] = g->nterms;  /* end of input */
+	*count = k;
+	return p;
+}
+
+/*
+ * Sentence of the tower grammar: n (oi n)* with nested parentheses,
+ * terminated by the end of input
+ */
+static size_t *tower_input (struct grammar *g, size_t n, size_t len,
+			    size_t *count)
+{
+	size_t *p, depth = 0, k = 0;
+	unsigned long seed = 1;
+
+	if ((p = malloc (sizeof (p[0]) * (len + 16))) == NULL)
+		err (1, "cannot allocate input");
+
+	for (;;) {
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+
+		if ((seed >> 40) % 8 == 0 && k + depth + 8 < len) {
+			p[k++] = token (g, "(", 0);
+			++depth;
+			continue;
+		}
+
+		p[k++] = token (g, "n", 0);
+
+		for (; depth > 0 && (seed >> 50) % 4 == 0; --depth, seed >>= 2)
+			p[k++] = token (g, ")", 0);
+
+		if (k + depth + 8 >= len)
+			break;
+
+		p[k++] = token (g, "o%zu", (seed >> 33) % n);
+	}
+
+	for (; depth > 0; --depth)
+		p[k++] = token (g, ")", 0);
+
+	p[k] = g->nterms;  /* end of input */
+	*count = k;
+	return p;
+}
+
+struct input {
+	const size_t *p;
+	size_t reductions;
+};
+
+static int input_lex (void *cookie, void **value)
+{
+	struct input *o = cookie;
+
+	*value = NULL;
+	return *o->p++;
+}
+
+static void *input_reduce (void *cookie, const struct rule *r, void **args)
+{
+	struct input *o = cookie;
+
+	++o->reductions;
+	return args[0];
+}
+
+static void bench_parse (const struct automata_table *t, const size_t *p,
+			 size_t count, int values)
+{
+	struct automata_parser c;
+	struct input in = { p, 0 };
+	double start, time;
+
+	if (!automata_parser_init (&c, t))
+		err (1, "cannot initialize parser");
+
+	c.lex    = input_lex;
+	c.reduce = values ? input_reduce : NULL;
+	c.cookie = &in;
+
+	start = now ();
+
+	if (!automata_parse (&c, NULL))
+		err (1, "cannot parse input");
+
+	time = now () - start;
+
+	printf ("parse : %zu tokens, %s, %.3f ms, %.1f Mtokens/s\n",
+		count, values ? "with values" : "no values", time * 1e3,
+		count / time * 1e-6);
+
+	automata_parser_fini (&c);
+}
+
+/*
+ * Emits code into memory stream, reports its size and emission speed
+ */
+static void bench_code (const void *o, int table)
+{
+	FILE *f;
+	char *buf;
+	size_t len;
+	double start, time;
+
+	if ((f = open_memstream (&buf, &len)) == NULL)
+		err (1, "cannot open memory stream");
+
+	start = now ();
+
+	if (table ? !automata_table_code (o, f) : !automata_code (o, f))
+		err (1, "cannot emit code");
+
+	if (fclose (f) != 0)
+		err (1, "cannot emit code");
+
+	time = now () - start;
+
+	printf ("code  : %-6s = %zu bytes, %.3f ms, %.1f MB/s\n",
+		table ? "table" : "switch", len, time * 1e3,
+		len / time * 1e-6);
+	free (buf);
+}
+
+int main (int argc, char *argv[])
+{
+	size_t rules = argc > 1 ? strtoul (argv[1], NULL, 0) : 3000;
+	const char *family = argc > 2 ? argv[2] : "wide";
+	size_t tokens = argc > 3 ? strtoul (argv[3], NULL, 0) : 10000000;
+	size_t count, cells, n;
+	struct gen gen;
+	struct grammar g;
+	struct automata a;
+	struct automata_table t;
+	size_t *input;
+	double start, time;
+
+	gen_init (&gen);
+
+	if (strcmp (family, "wide") != 0 && strcmp (family, "tower") != 0)
+		errx (1, "no input generator for grammar family %s", family);
+
+	gen_family (&gen, family, rules);
+
+	if (!grammar_init (&g))
+		err (1, "cannot initialize grammar");
+
+	if (!load_grammar (&g, gen.rules) || !grammar_number (&g))
+		err (1, "cannot load grammar");
+
+	if (!automata_init (&a))
+		err (1, "cannot initialize automata");
+
+	if (!automata_build (&a, &g) || !automata_lalr (&a))
+		err (1, "cannot build automata");
+
+	printf ("rules = %zu, states = %zu\n", g.nrules, a.states.count);
+
+	start = now ();
+
+	if (!automata_table_init (&t, &a))
+		err (1, "cannot build tables");
+
+	time = now () - start;
+	cells = t.nstates * (t.nsymbols + 1);
+
+	printf ("table : build = %.3f ms, entries = %zu of %zu, "
+		"comb size = %zu\n", time * 1e3, t.entries, cells, t.size);
+
+	bench_code (&a, 0);
+	bench_code (&t, 1);
+
+	if (family[0] == 'w') {
+		n = rules < 6 ? 1 : (rules - 1) / 3;
+		input = wide_input (&g, n, tokens, &count);
+	}
+	else {
+		n = rules < 6 ? 1 : (rules - 2) / 2;
+		input = tower_input (&g, n, tokens, &count);
+	}
+
+	bench_parse (&t, input, count, 0);
+	bench_parse (&t, input, count, 1);
+
+	free (input);
+	automata_table_fini (&t);
+	automata_fini (&a);
+	grammar_fini (&g);
+	gen_fini (&gen);
+	return 0;
+}